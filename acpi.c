@@ -0,0 +1,178 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "x86.h"
+#include "stdio.h"
+
+#include "acpi.h"
+
+#define MADT_LOCAL_APIC         0
+#define MADT_LOCAL_APIC_ENABLED (1 << 0)
+
+typedef struct rsdp {
+    char signature[8]; /* "RSD PTR " */
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_addr;
+    /* revision 2 */
+    uint32_t length;
+    uint64_t xsdt_addr;
+    uint8_t ext_checksum;
+    uint8_t reserved[3];
+} __attribute__((packed)) rsdp_t;
+
+typedef struct sdt_header {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) sdt_header_t;
+
+typedef struct madt {
+    sdt_header_t header;
+    uint32_t local_apic_addr;
+    uint32_t flags;
+    uint8_t entries[];
+} __attribute__((packed)) madt_t;
+
+typedef struct madt_local_apic {
+    uint8_t type;
+    uint8_t length;
+    uint8_t acpi_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__((packed)) madt_local_apic_t;
+
+static bool acpi_checksum_ok (const void* ptr, const unsigned len)
+{
+    const uint8_t* p = ptr;
+    uint8_t sum = 0;
+    for (unsigned i = 0; i < len; ++i) {
+        sum += p[i];
+    }
+    return sum == 0;
+}
+
+static bool acpi_signature (const char* sig, const char* match, const int len)
+{
+    for (int i = 0; i < len; ++i) {
+        if (sig[i] != match[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static rsdp_t* acpi_scan_rsdp (uintptr_t start, uintptr_t end)
+{
+    for (uintptr_t addr = start; addr < end; addr += 16) {
+        rsdp_t* rsdp = pointer_cast(rsdp_t*,addr);
+        if (acpi_signature (rsdp->signature, "RSD PTR ", 8) && acpi_checksum_ok (rsdp, 20)) {
+            return rsdp;
+        }
+    }
+    return NULL;
+}
+
+/* The RSDP is in the first KiB of the EBDA or in the BIOS area below 1MiB */
+static rsdp_t* acpi_find_rsdp (void)
+{
+    /* the EBDA segment is stored in the BIOS data area, hide the constant
+       address from gcc which takes it for an offset from a null pointer
+    */
+    uintptr_t bda_ebda = 0x40e;
+    asm ("" : "+r" (bda_ebda));
+    uintptr_t ebda = (uintptr_t)(*pointer_cast(uint16_t*,bda_ebda)) << 4;
+    rsdp_t* rsdp = NULL;
+
+    if (ebda) {
+        rsdp = acpi_scan_rsdp (ebda, ebda + 1024);
+    }
+    if (rsdp == NULL) {
+        rsdp = acpi_scan_rsdp (0xe0000, 0x100000);
+    }
+    return rsdp;
+}
+
+static madt_t* acpi_find_madt (const rsdp_t* rsdp)
+{
+    /* tables above 4GiB are not mapped */
+    if (rsdp->revision >= 2 && rsdp->xsdt_addr != 0 && (rsdp->xsdt_addr >> 32) == 0) {
+        sdt_header_t* xsdt = pointer_cast(sdt_header_t*,rsdp->xsdt_addr);
+        uint64_t* tables = (uint64_t*)(xsdt + 1);
+        unsigned n = (xsdt->length - sizeof(sdt_header_t)) / 8;
+        for (unsigned i = 0; i < n; ++i) {
+            sdt_header_t* sdt = pointer_cast(sdt_header_t*,tables[i]);
+            if ((tables[i] >> 32) == 0 && acpi_signature (sdt->signature, "APIC", 4)) {
+                return (madt_t*)sdt;
+            }
+        }
+    }
+
+    sdt_header_t* rsdt = pointer_cast(sdt_header_t*,rsdp->rsdt_addr);
+    uint32_t* tables = (uint32_t*)(rsdt + 1);
+    unsigned n = (rsdt->length - sizeof(sdt_header_t)) / 4;
+    for (unsigned i = 0; i < n; ++i) {
+        sdt_header_t* sdt = pointer_cast(sdt_header_t*,tables[i]);
+        if (acpi_signature (sdt->signature, "APIC", 4)) {
+            return (madt_t*)sdt;
+        }
+    }
+    return NULL;
+}
+
+int acpi_find_cpus (uint8_t apic_ids[ACPI_MAX_CPUS])
+{
+    rsdp_t* rsdp = acpi_find_rsdp ();
+    if (rsdp == NULL) {
+        return 0;
+    }
+
+    madt_t* madt = acpi_find_madt (rsdp);
+    if (madt == NULL || !acpi_checksum_ok (madt, madt->header.length)) {
+        return 0;
+    }
+
+    int count = 0;
+    uint8_t* entry = madt->entries;
+    uint8_t* end = ((uint8_t*)madt) + madt->header.length;
+    while (entry < end && entry[1] != 0) {
+        if (entry[0] == MADT_LOCAL_APIC) {
+            madt_local_apic_t* lapic = (madt_local_apic_t*)entry;
+            if ((lapic->flags & MADT_LOCAL_APIC_ENABLED) && count < ACPI_MAX_CPUS) {
+                apic_ids[count++] = lapic->apic_id;
+            }
+        }
+        entry += entry[1];
+    }
+    return count;
+}
@@ -0,0 +1,182 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "timebase.h"
+
+#include "apic.h"
+
+#define IA32_APIC_BASE        0x1b
+#define IA32_APIC_BASE_ENABLE (1 << 11)
+#define IA32_TSC_DEADLINE     0x6e0
+
+/* register offsets */
+#define APIC_ID        0x020
+#define APIC_EOI       0x0b0
+#define APIC_SVR       0x0f0
+#define APIC_ICR_LOW   0x300
+#define APIC_ICR_HIGH  0x310
+#define APIC_LVT_TIMER 0x320
+#define APIC_TIMER_ICR 0x380 /* initial count */
+#define APIC_TIMER_CCR 0x390 /* current count */
+#define APIC_TIMER_DCR 0x3e0 /* divide configuration */
+
+#define APIC_SVR_ENABLE         (1 << 8)
+#define APIC_LVT_MASKED         (1 << 16)
+#define APIC_LVT_TIMER_ONESHOT  (0 << 17)
+#define APIC_LVT_TIMER_DEADLINE (2 << 17)
+#define APIC_TIMER_DIV_16       0x3
+
+#define APIC_ICR_INIT           (5 << 8)
+#define APIC_ICR_STARTUP        (6 << 8)
+#define APIC_ICR_ASSERT         (1 << 14)
+#define APIC_ICR_PENDING        (1 << 12)
+
+#define CPUID1_EDX_APIC         (1 << 9)
+#define CPUID1_ECX_TSC_DEADLINE (1 << 24)
+
+#define CALIBRATE_MS 10
+
+static volatile uint32_t* apic_base;
+
+static bool tsc_deadline;
+
+/* APIC timer counts per TSC tick, 32.32 fixed point */
+static uint64_t apic_per_tick;
+
+static inline uint32_t apic_read (const uint32_t reg)
+{
+    return apic_base[reg/4];
+}
+
+static inline void apic_write (const uint32_t reg, const uint32_t val)
+{
+    apic_base[reg/4] = val;
+}
+
+bool apic_init (void)
+{
+    if (apic_base != NULL) {
+        return true;
+    }
+
+    if ((cpuid (0x01).edx & CPUID1_EDX_APIC) == 0) {
+        return false;
+    }
+
+    uint64_t base = rdmsr (IA32_APIC_BASE);
+    wrmsr (IA32_APIC_BASE, base | IA32_APIC_BASE_ENABLE);
+    apic_base = pointer_cast(volatile uint32_t*,(base & 0xfffff000));
+
+    apic_write (APIC_SVR, APIC_SVR_ENABLE | APIC_SPURIOUS_VECTOR);
+    return true;
+}
+
+void apic_eoi (void)
+{
+    apic_write (APIC_EOI, 0);
+}
+
+uint8_t apic_id (void)
+{
+    return (uint8_t)(apic_read (APIC_ID) >> 24);
+}
+
+static void apic_send_ipi (const uint8_t id, const uint32_t icr)
+{
+    apic_write (APIC_ICR_HIGH, (uint32_t)id << 24);
+    apic_write (APIC_ICR_LOW, icr);
+    while (apic_read (APIC_ICR_LOW) & APIC_ICR_PENDING);
+}
+
+void apic_send_init (const uint8_t id)
+{
+    apic_send_ipi (id, APIC_ICR_INIT | APIC_ICR_ASSERT);
+}
+
+void apic_send_startup (const uint8_t id, const uint8_t page)
+{
+    apic_send_ipi (id, APIC_ICR_STARTUP | APIC_ICR_ASSERT | page);
+}
+
+/* Measure the APIC timer rate against the TSC by letting it count down from
+   its maximum for CALIBRATE_MS.
+*/
+static uint64_t apic_timer_calibrate (void)
+{
+    const uint64_t tsc_hz = timebase_tsc_hz ();
+    const uint64_t wait = (tsc_hz * CALIBRATE_MS) / 1000;
+
+    apic_write (APIC_TIMER_DCR, APIC_TIMER_DIV_16);
+    apic_write (APIC_LVT_TIMER, APIC_LVT_MASKED | APIC_LVT_TIMER_ONESHOT | APIC_TIMER_VECTOR);
+    apic_write (APIC_TIMER_ICR, 0xffffffff);
+
+    uint64_t start = rdtsc ();
+    while ((rdtsc () - start) < wait);
+    uint32_t counted = 0xffffffff - apic_read (APIC_TIMER_CCR);
+
+    apic_write (APIC_TIMER_ICR, 0);
+
+    return ((uint64_t)counted << 32) / wait;
+}
+
+bool apic_timer_init (void)
+{
+    if (apic_base == NULL) {
+        return false;
+    }
+
+    tsc_deadline = (cpuid (0x01).ecx & CPUID1_ECX_TSC_DEADLINE) != 0;
+
+    if (tsc_deadline) {
+        apic_write (APIC_LVT_TIMER, APIC_LVT_TIMER_DEADLINE | APIC_TIMER_VECTOR);
+        printf ("APIC: timer in TSC-deadline mode\n");
+    } else {
+        apic_per_tick = apic_timer_calibrate ();
+        if (apic_per_tick == 0) {
+            return false;
+        }
+        apic_write (APIC_TIMER_DCR, APIC_TIMER_DIV_16);
+        apic_write (APIC_LVT_TIMER, APIC_LVT_TIMER_ONESHOT | APIC_TIMER_VECTOR);
+        printf ("APIC: timer in one-shot mode\n");
+    }
+    return true;
+}
+
+void apic_timer_arm (const uint64_t deadline)
+{
+    if (tsc_deadline) {
+        wrmsr (IA32_TSC_DEADLINE, deadline);
+    } else {
+        const uint64_t now = rdtsc ();
+        uint64_t count = 1;
+        if ((int64_t)(deadline - now) > 0) {
+            count = ((deadline - now) * apic_per_tick) >> 32;
+        }
+        apic_write (APIC_TIMER_ICR, (count > 0xffffffff) ? 0xffffffff : (count ? (uint32_t)count : 1));
+    }
+}
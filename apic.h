@@ -0,0 +1,49 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __APIC_H__
+#define __APIC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APIC_TIMER_VECTOR    48
+#define APIC_SPURIOUS_VECTOR 63
+
+/* Local APIC of the current CPU */
+bool apic_init (void);
+void apic_eoi (void);
+uint8_t apic_id (void);
+
+/* inter-processor interrupts used to start the other CPUs, 'page' is the 4KiB
+   page below 1MiB where they start executing in real mode
+*/
+void apic_send_init (const uint8_t id);
+void apic_send_startup (const uint8_t id, const uint8_t page);
+
+/* One-shot timer, in TSC-deadline mode where supported. The timer raises
+   APIC_TIMER_VECTOR when the TSC reaches 'deadline'.
+*/
+bool apic_timer_init (void);
+void apic_timer_arm (const uint64_t deadline);
+
+#endif /* __APIC_H__ */
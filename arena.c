@@ -0,0 +1,76 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "pmm.h"
+
+#include "arena.h"
+
+bool arena_init (arena_t* arena, const char* name, const size_t size)
+{
+    const size_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    arena->base = pmm_alloc_pages (pages);
+    arena->size = arena->base ? (pages * PAGE_SIZE) : 0;
+    arena->used = 0;
+    arena->name = name;
+
+    if (!arena->base) {
+        printf ("Arena '%s': no memory for %u KiB\n", name, (unsigned)(size >> 10));
+        return false;
+    }
+    return true;
+}
+
+void* arena_alloc (arena_t* arena, const size_t size, const size_t align)
+{
+    const size_t start = (arena->used + (align - 1)) & ~(align - 1);
+
+    if (start > arena->size || size > (arena->size - start)) {
+        return NULL;
+    }
+    arena->used = start + size;
+    memset (arena->base + start, 0, size);
+
+    return arena->base + start;
+}
+
+void arena_reset (arena_t* arena)
+{
+    arena->used = 0;
+}
+
+void arena_release (arena_t* arena)
+{
+    if (arena->base) {
+        pmm_free_pages (arena->base, arena->size / PAGE_SIZE);
+    }
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
@@ -0,0 +1,46 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* A bump allocator over contiguous pages from the PMM. Allocations are
+   never freed individually, only all at once with arena_reset/release.
+*/
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    const char* name;
+} arena_t;
+
+bool arena_init (arena_t* arena, const char* name, const size_t size);
+/* zeroed, 'align' must be a power of 2, NULL when full */
+void* arena_alloc (arena_t* arena, const size_t size, const size_t align);
+void arena_reset (arena_t* arena);
+void arena_release (arena_t* arena);
+
+#endif /* __ARENA_H__ */
@@ -0,0 +1,137 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "pci.h"
+
+#include "bga.h"
+
+#define BGA_PCI_VENDOR 0x1234
+#define BGA_PCI_DEVICE 0x1111
+
+#define VBE_DISPI_IOPORT_INDEX 0x01ce
+#define VBE_DISPI_IOPORT_DATA  0x01cf
+
+#define VBE_DISPI_INDEX_ID          0x0
+#define VBE_DISPI_INDEX_XRES        0x1
+#define VBE_DISPI_INDEX_YRES        0x2
+#define VBE_DISPI_INDEX_BPP         0x3
+#define VBE_DISPI_INDEX_ENABLE      0x4
+#define VBE_DISPI_INDEX_BANK        0x5
+#define VBE_DISPI_INDEX_VIRT_WIDTH  0x6
+#define VBE_DISPI_INDEX_VIRT_HEIGHT 0x7
+#define VBE_DISPI_INDEX_X_OFFSET    0x8
+#define VBE_DISPI_INDEX_Y_OFFSET    0x9
+
+#define VBE_DISPI_ID2 0xb0c2 /* first version supporting 24/32 bpp */
+
+#define VBE_DISPI_DISABLED    0x00
+#define VBE_DISPI_ENABLED     0x01
+#define VBE_DISPI_LFB_ENABLED 0x40
+
+/* height of one page, the Y offset of page n is n*page_height */
+static int page_height;
+
+static inline void bga_write (const uint16_t index, const uint16_t val)
+{
+    outport16 (VBE_DISPI_IOPORT_INDEX, index);
+    outport16 (VBE_DISPI_IOPORT_DATA, val);
+}
+
+static inline uint16_t bga_read (const uint16_t index)
+{
+    outport16 (VBE_DISPI_IOPORT_INDEX, index);
+    return inport16 (VBE_DISPI_IOPORT_DATA);
+}
+
+/* Probe for the adapter on the PCI bus and set a width x height x bpp mode
+   with room for two pages, returns false if either is not possible.
+*/
+bool bga_init (const int width, const int height, const int bpp, bga_mode_t* mode)
+{
+    pci_device_t pdev;
+
+    if (!pci_find_device (BGA_PCI_VENDOR, BGA_PCI_DEVICE, &pdev)) {
+        return false;
+    }
+
+    uint16_t id = bga_read (VBE_DISPI_INDEX_ID);
+    if (id < VBE_DISPI_ID2) {
+        printf ("BGA: unsupported version %04x\n", id);
+        return false;
+    }
+
+    /* the mode GRUB set, put back if ours does not fit */
+    const uint16_t saved_enable = bga_read (VBE_DISPI_INDEX_ENABLE);
+    const uint16_t saved_xres = bga_read (VBE_DISPI_INDEX_XRES);
+    const uint16_t saved_yres = bga_read (VBE_DISPI_INDEX_YRES);
+    const uint16_t saved_bpp = bga_read (VBE_DISPI_INDEX_BPP);
+    const uint16_t saved_virt_width = bga_read (VBE_DISPI_INDEX_VIRT_WIDTH);
+    const uint16_t saved_virt_height = bga_read (VBE_DISPI_INDEX_VIRT_HEIGHT);
+
+    bga_write (VBE_DISPI_INDEX_ENABLE, VBE_DISPI_DISABLED);
+    bga_write (VBE_DISPI_INDEX_XRES, width);
+    bga_write (VBE_DISPI_INDEX_YRES, height);
+    bga_write (VBE_DISPI_INDEX_BPP, bpp);
+    bga_write (VBE_DISPI_INDEX_VIRT_WIDTH, width);
+    bga_write (VBE_DISPI_INDEX_VIRT_HEIGHT, height * 2);
+    bga_write (VBE_DISPI_INDEX_ENABLE, VBE_DISPI_ENABLED | VBE_DISPI_LFB_ENABLED);
+
+    /* the virtual height is limited by the amount of video memory */
+    if (bga_read (VBE_DISPI_INDEX_XRES) != width ||
+        bga_read (VBE_DISPI_INDEX_YRES) != height ||
+        bga_read (VBE_DISPI_INDEX_BPP) != bpp ||
+        bga_read (VBE_DISPI_INDEX_VIRT_HEIGHT) < (height * 2)) {
+        printf ("BGA: %ux%ux%u with two pages not supported\n", width, height, bpp);
+        bga_write (VBE_DISPI_INDEX_ENABLE, VBE_DISPI_DISABLED);
+        bga_write (VBE_DISPI_INDEX_XRES, saved_xres);
+        bga_write (VBE_DISPI_INDEX_YRES, saved_yres);
+        bga_write (VBE_DISPI_INDEX_BPP, saved_bpp);
+        bga_write (VBE_DISPI_INDEX_VIRT_WIDTH, saved_virt_width);
+        bga_write (VBE_DISPI_INDEX_VIRT_HEIGHT, saved_virt_height);
+        bga_write (VBE_DISPI_INDEX_Y_OFFSET, 0);
+        bga_write (VBE_DISPI_INDEX_ENABLE, saved_enable);
+        return false;
+    }
+
+    page_height = height;
+    bga_flip (0);
+
+    mode->fb = pointer_cast(uint8_t*,pci_config_read32 (&pdev, PCI_BAR0) & ~0xfu);
+    mode->width = width;
+    mode->height = height;
+    mode->bpp = bpp;
+    mode->pitch = bga_read (VBE_DISPI_INDEX_VIRT_WIDTH) * ((bpp + 7) / 8);
+
+    printf ("BGA: %04x %ux%ux%u fb 0x%08x, 2 pages\n", id, width, height, bpp, (unsigned)(uintptr_t)mode->fb);
+    return true;
+}
+
+/* Show 'page', no copy is required */
+void bga_flip (const int page)
+{
+    bga_write (VBE_DISPI_INDEX_Y_OFFSET, page * page_height);
+}
@@ -0,0 +1,43 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __BGA_H__
+#define __BGA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Bochs Graphics Adapter (QEMU "-vga std") with a virtual height of two
+   screens, the visible screen is selected with the Y offset register.
+*/
+typedef struct bga_mode {
+    uint8_t* fb;   /* linear frame buffer, both pages */
+    int width;
+    int height;
+    int bpp;
+    int pitch;     /* bytes per row */
+} bga_mode_t;
+
+bool bga_init (const int width, const int height, const int bpp, bga_mode_t* mode);
+void bga_flip (const int page);
+
+#endif /* __BGA_H__ */
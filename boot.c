@@ -0,0 +1,48 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+
+#include "stdio.h"
+#include "timebase.h"
+#include "cmdline.h"
+
+#include "boot.h"
+
+static const char* phase_names[BOOT_PHASES] = {
+    "entry", "bss", "paging", "idt", "rom", "first frame",
+};
+
+void boot_report (void)
+{
+    if (!cmdline_has ("bootdebug")) {
+        return;
+    }
+
+    printf ("boot: tsc at entry %u:%08x\n", (unsigned)(boot_tsc[BOOT_ENTRY] >> 32),
+            (unsigned)boot_tsc[BOOT_ENTRY]);
+    for (int i = 1; i < BOOT_PHASES; ++i) {
+        const uint64_t phase = timebase_ticks_to_ns (boot_tsc[i] - boot_tsc[i-1]) / 1000;
+        const uint64_t total = timebase_ticks_to_ns (boot_tsc[i] - boot_tsc[BOOT_ENTRY]) / 1000;
+        printf ("boot: %12s %8uus %8uus\n", phase_names[i], (unsigned)phase, (unsigned)total);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+/* boot phases, the TSC is recorded at the end of each */
+#define BOOT_ENTRY       0 /* _boot_start */
+#define BOOT_BSS         1 /* .bss cleared */
+#define BOOT_PAGING      2 /* long mode page tables, the same as BOOT_BSS on i386 */
+#define BOOT_IDT         3 /* interrupt descriptors and PICs */
+#define BOOT_ROM         4 /* 8080 ROM loaded */
+#define BOOT_FIRST_FRAME 5 /* first complete frame drawn */
+#define BOOT_PHASES      6
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+#include "x86.h"
+
+/* written by start.S before .bss is cleared so it is in .data */
+extern uint64_t boot_tsc[BOOT_PHASES];
+
+static inline void boot_stamp (const int phase)
+{
+    boot_tsc[phase] = rdtsc ();
+}
+
+/* print the time taken by each phase if the "bootdebug" option is given */
+void boot_report (void);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* __BOOT_H__ */
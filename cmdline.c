@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "multiboot.h"
+#include "x86.h"
+#include "stdio.h"
+
+#include "cmdline.h"
+
+static const char* cmdline = "";
+
+void cmdline_init (multiboot_info_t *mbi)
+{
+    if (mbi->flags & MULTIBOOT_INFO_CMDLINE) {
+        cmdline = pointer_cast(const char*,mbi->cmdline);
+        printf ("Command line: %s\n", cmdline);
+    }
+}
+
+/* Find option 'name', returns a pointer to the character after the name,
+   either '=', ' ' or '\0', or NULL if it is not there. The first word is
+   the kernel file name and is skipped.
+*/
+static const char* cmdline_find (const char* name)
+{
+    const char* p = cmdline;
+
+    while (*p && *p != ' ') {
+        p++;
+    }
+
+    while (*p) {
+        while (*p == ' ') {
+            p++;
+        }
+
+        int i = 0;
+        while (name[i] && p[i] == name[i]) {
+            i++;
+        }
+        if (name[i] == '\0' && (p[i] == '=' || p[i] == ' ' || p[i] == '\0')) {
+            return &p[i];
+        }
+
+        while (*p && *p != ' ') {
+            p++;
+        }
+    }
+
+    return NULL;
+}
+
+bool cmdline_has (const char* name)
+{
+    return cmdline_find (name) != NULL;
+}
+
+bool cmdline_get (const char* name, char* buf, const int size)
+{
+    const char* p = cmdline_find (name);
+    int i = 0;
+
+    if (p == NULL || *p != '=' || size < 1) {
+        return false;
+    }
+
+    for (p++; *p && *p != ' ' && i < (size - 1); p++) {
+        buf[i++] = *p;
+    }
+    buf[i] = '\0';
+
+    return true;
+}
+
+int cmdline_get_int (const char* name, const int def)
+{
+    char buf[16];
+    int val = 0;
+
+    if (!cmdline_get (name, buf, sizeof(buf)) || buf[0] == '\0') {
+        return def;
+    }
+
+    for (int i = 0; buf[i]; ++i) {
+        if (buf[i] < '0' || buf[i] > '9') {
+            printf ("[error] option %s: bad number '%s'\n", name, buf);
+            return def;
+        }
+        val = (val * 10) + (buf[i] - '0');
+    }
+
+    return val;
+}
@@ -0,0 +1,46 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __CMDLINE_H__
+#define __CMDLINE_H__
+
+#include <stdbool.h>
+
+#include "multiboot.h"
+
+/* Options are given on the boot loader's kernel command line as
+   space separated words, either "name" or "name=value".
+*/
+void cmdline_init (multiboot_info_t *mbi);
+
+/* true if option 'name' is present */
+bool cmdline_has (const char* name);
+
+/* copy the value of option 'name' into 'buf', returns false if the option
+   is not present or has no value
+*/
+bool cmdline_get (const char* name, char* buf, const int size);
+
+/* the value of option 'name' as a decimal number, or 'def' */
+int cmdline_get_int (const char* name, const int def);
+
+#endif /* __CMDLINE_H__ */
@@ -22,11 +22,18 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "multiboot.h"
 #include "x86.h"
 #include "i8080.h"
 #include "stdio.h"
+#include "bga.h"
+#include "hud.h"
+#include "telemetry.h"
+#include "smp.h"
+#include "pmu.h"
+#include "boot.h"
 
 #include "graphics.h"
 
@@ -39,18 +46,77 @@
 #define i8080_FONT_HEIGHT 8
 
 #define YELLOW 0x00ffff00
-#define WHITE  0xffffffff
+#define WHITE  0x00ffffff
+#define RED    0x00ff2020
+#define GREEN  0x0020ff20
+
+/* The cabinet had strips of coloured cellophane over the monitor, these are
+   the screen rows (top = 0) covered by each strip.
+*/
+#if !defined(COLOUR_OVERLAY)
+#define COLOUR_OVERLAY 1
+#endif
+#define OVERLAY_RED_FIRST    32  /* flying saucer */
+#define OVERLAY_RED_LAST     63
+#define OVERLAY_GREEN_FIRST  184 /* shields and player */
+#define OVERLAY_GREEN_LAST   239
 
 #define PRINT_BUF_SIZE 256
 
-static void graphics_update (void);
+/* largest supported integer scale of the game image */
+#define MAX_SCALE 4
+
+/* bytes per vram row, each row is one column of the screen */
+#define i8080_VRAM_STRIDE (i8080_VRAM_WIDTH/8)
+
+/* number of rendered frames between reports of the skipped fraction */
+#define DIFF_REPORT_FRAMES 600
+
+struct graphics_view;
+static void graphics_update (struct graphics_view* view, const uint8_t* pixels, const int half);
+static void graphics_load_font (void);
+
+/* The screen is rendered in two halves, the top half on the mid screen
+   interrupt and the bottom half on the end of screen interrupt.
+*/
+#define SCREEN_HALF_TOP    0
+#define SCREEN_HALF_BOTTOM 1
+
+/* Expand one screen row of 1bpp pixel data into native pixels. The source
+   pixels are taken from bit 'bit' of every 'stride'th byte of 'src', each is
+   written 'scale' times and 'colour' is already in the frame buffer's native
+   pixel format.
+*/
+typedef void (*blit_fn_t) (uint8_t* dst, const uint8_t* src, const int stride, const int len, const int bit, const uint32_t colour, const int scale);
 
-/* Screen frame buffer pointer */
-static uint32_t* screen_fb;
+/* Screen frame buffer pointer, the page being drawn */
+static uint8_t* screen_fb;
+
+/* With the Bochs graphics adapter there are two pages, one is shown while
+   the other is drawn and they are swapped at the end of each frame.
+*/
+static bool page_flip;
+static int draw_page;
+static uint8_t* page_fb[2];
 
 /* Screen resolution */
 static int screen_width;
 static int screen_height;
+static int screen_pitch; /* bytes per frame buffer row */
+static int screen_bypp;  /* bytes per pixel */
+
+/* Row blitter for the frame buffer pixel format, selected in graphics_init */
+static blit_fn_t blit_row;
+
+/* Integer scale of the game image */
+static int game_scale;
+
+/* Colours converted to the frame buffer pixel format */
+static uint32_t white_px;
+static uint32_t yellow_px;
+
+/* Foreground colour of each game screen row, white or the overlay colour */
+static uint32_t row_colour[i8080_VRAM_WIDTH];
 
 /* i8080 cpu state structure */
 static i8080_state_t* i8080_state_ptr;
@@ -60,6 +126,9 @@ typedef struct point {
     int y;
 } point_t;
 
+/* used by the 16 byte compare of vram rows */
+typedef char v16qi_t __attribute__((vector_size(16), aligned(1)));
+
 typedef struct font_entry {
     int character;
     int offset;
@@ -68,12 +137,59 @@ typedef struct font_entry {
 /* current location of the text cursor */
 static point_t cursor;
 
+/* One game image on the screen. There is a single view in the middle of the
+   screen unless graphics_tile has divided the screen between several
+   machines, each view is only drawn by the CPU running its machine.
+*/
+typedef struct graphics_view {
+    /* Copy of the vram as last rendered, only the differences are redrawn */
+    uint8_t vram_prev[2][i8080_VRAM_HEIGHT * i8080_VRAM_STRIDE] __attribute__((aligned(16)));
+    bool vram_prev_valid[2][2]; /* per page and screen half */
+
+    /* A scaled screen row is built here once and then copied to the frame
+       buffer 'scale' times, this avoids both recomputing it and reading back
+       from video memory.
+    */
+    uint8_t span[i8080_VRAM_HEIGHT * MAX_SCALE * 4] __attribute__((aligned(16)));
+
+    /* Top left corner of the game on the screen */
+    point_t pos;
+
+    /* frame diffing statistics */
+    unsigned diff_frames;
+    unsigned long diff_pixels_drawn;
+} graphics_view_t;
+
+static graphics_view_t views[GRAPHICS_MAX_VIEWS];
+static int nr_views;
+
+/* VRAM snapshots passed to the render core, a lock-free triple buffer. The
+   emulator CPU fills snap_write and swaps it with snap_ready, the render core
+   takes snap_ready when SNAP_FRESH is set and swaps in snap_read. Neither side
+   ever waits, an unrendered snapshot is simply replaced by a newer one.
+*/
+#define SNAP_INDEX 0x3
+#define SNAP_FRESH 0x4
+
+typedef struct vram_snapshot {
+    uint8_t vram[i8080_VRAM_HEIGHT * i8080_VRAM_STRIDE] __attribute__((aligned(16)));
+    int half;
+} vram_snapshot_t;
+
+static vram_snapshot_t snaps[3];
+static unsigned snap_write;
+static unsigned snap_ready = 1;
+static unsigned snap_read = 2;
+static bool render_core;
+
 /* The Space Invader font is 8x8 pixels. This table defines the offsets into
    the start of the font data for each charater. Each charater consists of
    8 bytes of data.
 */
 #define FONT_TABLE_ENTRY_OFFSET(x) ((x)*8)
-static font_entry_t font_table[] = {
+static const font_entry_t font_table[] = {
+    /* first, characters that are not in the font are shown as '?' */
+    {'?', FONT_TABLE_ENTRY_OFFSET(56)},
     {'a', FONT_TABLE_ENTRY_OFFSET(0)},
     {'b', FONT_TABLE_ENTRY_OFFSET(1)},
     {'c', FONT_TABLE_ENTRY_OFFSET(2)},
@@ -116,13 +232,35 @@ static font_entry_t font_table[] = {
     {'=', FONT_TABLE_ENTRY_OFFSET(39)},
     {'*', FONT_TABLE_ENTRY_OFFSET(40)},
     /* ... */
-    {'?', FONT_TABLE_ENTRY_OFFSET(56)},
-    /* ... */
     {'-', FONT_TABLE_ENTRY_OFFSET(63)},
 };
 
-/* map of ascii value to index in font_table */
-static int font_map[128]; /* ascii characters 0...127 */
+/* map of ascii value to index in font_table, upper case letters use the
+   lower case glyphs and everything else is 0 ('?')
+*/
+static const uint8_t font_map[128] = {
+    ['a'] = 1, ['A'] = 1, ['b'] = 2, ['B'] = 2, ['c'] = 3, ['C'] = 3,
+    ['d'] = 4, ['D'] = 4, ['e'] = 5, ['E'] = 5, ['f'] = 6, ['F'] = 6,
+    ['g'] = 7, ['G'] = 7, ['h'] = 8, ['H'] = 8, ['i'] = 9, ['I'] = 9,
+    ['j'] = 10, ['J'] = 10, ['k'] = 11, ['K'] = 11, ['l'] = 12, ['L'] = 12,
+    ['m'] = 13, ['M'] = 13, ['n'] = 14, ['N'] = 14, ['o'] = 15, ['O'] = 15,
+    ['p'] = 16, ['P'] = 16, ['q'] = 17, ['Q'] = 17, ['r'] = 18, ['R'] = 18,
+    ['s'] = 19, ['S'] = 19, ['t'] = 20, ['T'] = 20, ['u'] = 21, ['U'] = 21,
+    ['v'] = 22, ['V'] = 22, ['w'] = 23, ['W'] = 23, ['x'] = 24, ['X'] = 24,
+    ['y'] = 25, ['Y'] = 25, ['z'] = 26, ['Z'] = 26, ['0'] = 27, ['1'] = 28,
+    ['2'] = 29, ['3'] = 30, ['4'] = 31, ['5'] = 32, ['6'] = 33, ['7'] = 34,
+    ['8'] = 35, ['9'] = 36, ['<'] = 37, ['>'] = 38, [' '] = 39, ['='] = 40,
+    ['*'] = 41, ['-'] = 42,
+};
+
+#define NR_GLYPHS (sizeof(font_table)/sizeof(font_table[0]))
+#define GLYPH_ROW_BYTES (i8080_FONT_WIDTH * 4)
+#define LINE_HEIGHT (i8080_FONT_HEIGHT + 2) /* 2 pixels space between rows */
+
+/* Each character of the font rasterised once, already rotated and in the
+   frame buffer pixel format, drawing text is a copy of these tiles.
+*/
+static uint8_t glyph_tiles[NR_GLYPHS][i8080_FONT_HEIGHT][GLYPH_ROW_BYTES] __attribute__((aligned(16)));
 
 static void graphics_show_info (multiboot_info_t *mbi)
 {
@@ -147,131 +285,599 @@ static void graphics_show_info (multiboot_info_t *mbi)
     }
 }
 
-void timer_irq_handler (void)
+/* show the page that has just been drawn and start drawing the other one */
+static void graphics_present (void)
+{
+    if (page_flip) {
+        bga_flip (draw_page);
+        draw_page ^= 1;
+        screen_fb = page_fb[draw_page];
+    }
+}
+
+/* scale an 8 bit colour component to 'size' bits */
+static uint32_t graphics_scale_component (const unsigned c, const unsigned size)
+{
+    return (size > 8) ? (c << (size - 8)) : (c >> (8 - size));
+}
+
+/* Convert a 0x00RRGGBB colour to the frame buffer's native pixel value */
+static uint32_t graphics_map_rgb (multiboot_info_t *mbi, uint32_t rgb)
+{
+    const unsigned r = (rgb >> 16) & 0xff;
+    const unsigned g = (rgb >>  8) & 0xff;
+    const unsigned b = (rgb >>  0) & 0xff;
+
+    if (mbi->framebuffer_type == MULTIBOOT_FRAMEBUFFER_TYPE_INDEXED) {
+        /* pick the nearest palette entry */
+        struct multiboot_color* palette = pointer_cast(struct multiboot_color*,mbi->framebuffer_palette_addr);
+        unsigned best = 0;
+        unsigned best_dist = ~0u;
+        for (unsigned i = 0; i < mbi->framebuffer_palette_num_colors; ++i) {
+            int dr = palette[i].red - r;
+            int dg = palette[i].green - g;
+            int db = palette[i].blue - b;
+            unsigned dist = dr*dr + dg*dg + db*db;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /* direct colour: scale each component to its mask size */
+    return ((graphics_scale_component (r, mbi->framebuffer_red_mask_size) << mbi->framebuffer_red_field_position) |
+            (graphics_scale_component (g, mbi->framebuffer_green_mask_size) << mbi->framebuffer_green_field_position) |
+            (graphics_scale_component (b, mbi->framebuffer_blue_mask_size) << mbi->framebuffer_blue_field_position));
+}
+
+/* expand a single bit to a pixel mask, all ones if set, zero otherwise */
+static inline uint32_t pixel_mask (const uint8_t byte, const int bit)
+{
+    return -(uint32_t)((byte >> bit) & 1);
+}
+
+static void blit_row_32 (uint8_t* dst, const uint8_t* src, const int stride, const int len, const int bit, const uint32_t colour, const int scale)
+{
+    uint32_t* px = (uint32_t*)dst;
+    for (int i = 0; i < len; ++i) {
+        const uint32_t c = pixel_mask (src[i*stride], bit) & colour;
+        for (int k = 0; k < scale; ++k) {
+            *px++ = c;
+        }
+    }
+}
+
+static void blit_row_24 (uint8_t* dst, const uint8_t* src, const int stride, const int len, const int bit, const uint32_t colour, const int scale)
+{
+    for (int i = 0; i < len; ++i) {
+        const uint32_t c = pixel_mask (src[i*stride], bit) & colour;
+        for (int k = 0; k < scale; ++k) {
+            *dst++ = (uint8_t)(c >>  0);
+            *dst++ = (uint8_t)(c >>  8);
+            *dst++ = (uint8_t)(c >> 16);
+        }
+    }
+}
+
+static void blit_row_16 (uint8_t* dst, const uint8_t* src, const int stride, const int len, const int bit, const uint32_t colour, const int scale)
+{
+    uint16_t* px = (uint16_t*)dst;
+    for (int i = 0; i < len; ++i) {
+        const uint16_t c = (uint16_t)(pixel_mask (src[i*stride], bit) & colour);
+        for (int k = 0; k < scale; ++k) {
+            *px++ = c;
+        }
+    }
+}
+
+static void blit_row_8 (uint8_t* dst, const uint8_t* src, const int stride, const int len, const int bit, const uint32_t colour, const int scale)
+{
+    for (int i = 0; i < len; ++i) {
+        const uint8_t c = (uint8_t)(pixel_mask (src[i*stride], bit) & colour);
+        for (int k = 0; k < scale; ++k) {
+            *dst++ = c;
+        }
+    }
+}
+
+static blit_fn_t graphics_select_blitter (const int bpp)
+{
+    switch (bpp) {
+    case 32: return blit_row_32;
+    case 24: return blit_row_24;
+    case 16: /* fall through */
+    case 15: return blit_row_16;
+    case 8:  return blit_row_8;
+    default: return NULL;
+    }
+}
+
+/* draw one half of the screen from 'pixels' and show the frame once it is
+   complete
+*/
+static void graphics_render (graphics_view_t* view, const uint8_t* pixels, const int half)
+{
+    pmu_counts_t counts;
+    if (view == &views[0]) {
+        pmu_read (&counts);
+    }
+
+    const uint64_t start = rdtsc ();
+
+    graphics_update (view, pixels, half);
+    if (half == SCREEN_HALF_BOTTOM) {
+        graphics_present ();
+        if (view == &views[0] && boot_tsc[BOOT_FIRST_FRAME] == 0) {
+            boot_stamp (BOOT_FIRST_FRAME);
+            boot_report ();
+        }
+    }
+
+    const uint64_t end = rdtsc ();
+    if (view == &views[0]) {
+        pmu_render (&counts);
+        telemetry_render (start, end);
+        hud_tick (end - start, half == SCREEN_HALF_BOTTOM);
+    }
+}
+
+/* Entry point of the render core, all drawing to the frame buffer is done
+   here once it is running.
+*/
+static void graphics_render_core (void)
+{
+    int last_half = SCREEN_HALF_BOTTOM;
+
+    pmu_cpu_init ();
+
+    for (;;) {
+        while (!(__atomic_load_n (&snap_ready, __ATOMIC_ACQUIRE) & SNAP_FRESH)) {
+            asm volatile ("pause");
+        }
+        snap_read = __atomic_exchange_n (&snap_ready, snap_read, __ATOMIC_ACQ_REL) & SNAP_INDEX;
+
+        /* The top half snapshot of this frame was replaced before it was
+           taken. Each snapshot holds the whole of the vram, so draw the top
+           from this one or the page shown next has a top half two frames old.
+        */
+        const vram_snapshot_t* snap = &snaps[snap_read];
+        if (snap->half == SCREEN_HALF_BOTTOM && last_half != SCREEN_HALF_TOP) {
+            graphics_render (&views[0], snap->vram, SCREEN_HALF_TOP);
+        }
+        graphics_render (&views[0], snap->vram, snap->half);
+        last_half = snap->half;
+    }
+}
+
+/* hand a copy of the vram to the render core */
+static void graphics_publish (const uint8_t* pixels, const int half)
+{
+    vram_snapshot_t* snap = &snaps[snap_write];
+
+    memcpy (snap->vram, pixels, sizeof(snap->vram));
+    snap->half = half;
+    snap_write = __atomic_exchange_n (&snap_ready, snap_write | SNAP_FRESH, __ATOMIC_ACQ_REL) & SNAP_INDEX;
+}
+
+bool graphics_start_render_core (const int cpu)
 {
+    if (blit_row == NULL || !smp_start_cpu (cpu, graphics_render_core)) {
+        return false;
+    }
+    render_core = true;
+    printf ("Rendering on cpu %d\n", cpu);
+    return true;
+}
+
+/* timer event at the mid screen and end of screen points of each frame */
+void graphics_screen_event (void)
+{
+    const int frame_done = ((i8080_state_ptr->irq_set_cnt + 1) & 1) == 0;
+    const uint8_t* pixels = &i8080_state_ptr->mem[i8080_VRAM_BUFFER_ADDR];
+
+    /* the previous screen interrupt has not been taken yet */
+    if (i8080_state_ptr->irq_set_cnt != i8080_state_ptr->irq_clr_cnt) {
+        hud_irq_late ();
+    }
+
     i8080_state_ptr->irq_set_cnt++;
-    /* update the frame buffer on the end of screen interrupt */
-    if ((i8080_state_ptr->irq_set_cnt & 1) == 0) {
-        graphics_update();
+
+    /* The beam is at the middle of the screen on odd ticks and at the end on
+       even ticks, the ROM updates the half the beam has just left so draw
+       that half now.
+    */
+    const int half = frame_done ? SCREEN_HALF_BOTTOM : SCREEN_HALF_TOP;
+    if (render_core) {
+        graphics_publish (pixels, half);
+    } else {
+        graphics_render (&views[0], pixels, half);
     }
 }
 
-static void timer_init (uint32_t frequency)
+void graphics_view_event (const int view, i8080_state_t* state)
+{
+    const int frame_done = ((state->irq_set_cnt + 1) & 1) == 0;
+
+    state->irq_set_cnt++;
+    graphics_render (&views[view], &state->mem[i8080_VRAM_BUFFER_ADDR],
+                     frame_done ? SCREEN_HALF_BOTTOM : SCREEN_HALF_TOP);
+}
+
+/* Find the grid of 'cols' columns with the largest scale at which 'nr' games
+   fit on the screen, returns the scale or 0 if they do not fit.
+*/
+static int graphics_tile_layout (const int nr, int* cols)
 {
-    uint32_t divisor = 1193180 / frequency;
-    outport8(0x43, 0x36);
-    uint8_t l = (uint8_t)(divisor & 0xff);
-    uint8_t h = (uint8_t)((divisor>>8) & 0xff);
-    outport8(0x40, l);
-    outport8(0x40, h);
+    int best = 0;
+
+    for (int c = 1; c <= nr; ++c) {
+        const int rows = (nr + c - 1) / c;
+        int scale = screen_width / (c * i8080_VRAM_HEIGHT);
+        if ((screen_height / (rows * i8080_VRAM_WIDTH)) < scale) {
+            scale = screen_height / (rows * i8080_VRAM_WIDTH);
+        }
+        if (scale > MAX_SCALE) {
+            scale = MAX_SCALE;
+        }
+        if (scale > best) {
+            best = scale;
+            *cols = c;
+        }
+    }
+
+    return best;
+}
+
+int graphics_tile (int nr)
+{
+    int cols = 1;
+
+    if (blit_row == NULL || render_core) {
+        return 1;
+    }
+    if (nr > GRAPHICS_MAX_VIEWS) {
+        nr = GRAPHICS_MAX_VIEWS;
+    }
+    while (nr > 1 && graphics_tile_layout (nr, &cols) == 0) {
+        nr--;
+    }
+    if (nr <= 1) {
+        return 1;
+    }
+
+    game_scale = graphics_tile_layout (nr, &cols);
+    const int rows = (nr + cols - 1) / cols;
+    const int tile_w = i8080_VRAM_HEIGHT * game_scale;
+    const int tile_h = i8080_VRAM_WIDTH * game_scale;
+    const int x0 = (screen_width - cols * tile_w) / 2;
+    const int y0 = (screen_height - rows * tile_h) / 2;
+
+    for (int i = 0; i < nr; ++i) {
+        views[i].pos.x = x0 + (i % cols) * tile_w;
+        views[i].pos.y = y0 + (i / cols) * tile_h;
+        for (int page = 0; page < 2; ++page) {
+            views[i].vram_prev_valid[page][SCREEN_HALF_TOP] = false;
+            views[i].vram_prev_valid[page][SCREEN_HALF_BOTTOM] = false;
+        }
+    }
+    nr_views = nr;
+
+    /* the views are drawn and completed independently, there is no single
+       point at which to flip pages so draw to the page on screen
+    */
+    if (page_flip) {
+        page_flip = false;
+        draw_page = 0;
+        screen_fb = page_fb[0];
+    }
+
+    printf ("Tiled %u games in %u columns at %ux\n", nr, cols, game_scale);
+
+    return nr;
 }
 
 void graphics_init (multiboot_info_t *mbi, i8080_state_t* state)
 {
     i8080_state_ptr = state;
 
-    screen_fb = pointer_cast(uint32_t*,mbi->framebuffer_addr);
+    screen_fb = pointer_cast(uint8_t*,mbi->framebuffer_addr);
     screen_width = mbi->framebuffer_width;
     screen_height = mbi->framebuffer_height;
+    screen_pitch = mbi->framebuffer_pitch;
+    screen_bypp = (mbi->framebuffer_bpp + 7) / 8;
 
     graphics_show_info (mbi);
 
-    /* fill font_map */
-    int qmark_idx = (sizeof(font_table)/sizeof(font_table[0])) - 1;
-    for (unsigned i = 0; i < (sizeof(font_map)/sizeof(font_map[0])); ++i) {
-        int character = i;
+    blit_row = NULL;
+    if ((mbi->flags & MULTIBOOT_INFO_FRAMEBUFFER_INFO) &&
+        (mbi->framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_EGA_TEXT)) {
+        blit_row = graphics_select_blitter (mbi->framebuffer_bpp);
+    }
 
-        /* if A...Z convert to lower case */
-        if (character >= 0x41 && character <= 0x5a) {
-            character += 0x20;
+    /* Re-program the same mode on a Bochs graphics adapter for page flipping,
+       the pixel format is unchanged so the multiboot colour info still holds.
+    */
+    bga_mode_t mode;
+    page_flip = false;
+    draw_page = 0;
+    if (blit_row != NULL && bga_init (screen_width, screen_height, mbi->framebuffer_bpp, &mode)) {
+        page_flip = true;
+        screen_pitch = mode.pitch;
+        page_fb[0] = mode.fb;
+        page_fb[1] = mode.fb + (screen_height * screen_pitch);
+        draw_page = 1;
+        screen_fb = page_fb[draw_page];
+    }
+    if (blit_row == NULL) {
+        printf ("[error]: unsupported frame buffer format, %ubpp type %u\n",
+                mbi->framebuffer_bpp, mbi->framebuffer_type);
+    } else {
+        white_px = graphics_map_rgb (mbi, WHITE);
+        yellow_px = graphics_map_rgb (mbi, YELLOW);
+
+        uint32_t red_px = graphics_map_rgb (mbi, RED);
+        uint32_t green_px = graphics_map_rgb (mbi, GREEN);
+        for (int row = 0; row < i8080_VRAM_WIDTH; ++row) {
+            row_colour[row] = white_px;
+            if (COLOUR_OVERLAY && row >= OVERLAY_RED_FIRST && row <= OVERLAY_RED_LAST) {
+                row_colour[row] = red_px;
+            }
+            if (COLOUR_OVERLAY && row >= OVERLAY_GREEN_FIRST && row <= OVERLAY_GREEN_LAST) {
+                row_colour[row] = green_px;
+            }
         }
+    }
 
-        font_map[character] = qmark_idx; /* default */
-        for (unsigned j = 0; j < (sizeof(font_table)/sizeof(font_table[0])); ++j) {
-            if (font_table[j].character == character) {
-                font_map[i] = j;
-                break;
+    /* largest integer scale at which the rotated game fits the screen */
+    game_scale = screen_width / i8080_VRAM_HEIGHT;
+    if ((screen_height / i8080_VRAM_WIDTH) < game_scale) {
+        game_scale = screen_height / i8080_VRAM_WIDTH;
+    }
+    if (game_scale > MAX_SCALE) {
+        game_scale = MAX_SCALE;
+    }
+    if (game_scale < 1) {
+        game_scale = 1;
+    }
+    printf ("Game scale: %ux\n", game_scale);
+
+    nr_views = 1;
+    views[0].pos.x = (screen_width - i8080_VRAM_HEIGHT*game_scale) / 2;
+    views[0].pos.y = (screen_height - i8080_VRAM_WIDTH*game_scale) / 2;
+    for (int page = 0; page < 2; ++page) {
+        views[0].vram_prev_valid[page][SCREEN_HALF_TOP] = false;
+        views[0].vram_prev_valid[page][SCREEN_HALF_BOTTOM] = false;
+    }
+
+    graphics_load_font ();
+
+    hud_init (state);
+}
+
+/* Draw screen row 'row' of a 1bpp block whose top left corner is at 'dst',
+   only the 'count' pixels starting at column 'first' are drawn. The row is
+   expanded by the blitter for the frame buffer pixel format into a scaled
+   span which is then copied 'scale' times into the frame buffer.
+*/
+static inline void graphics_draw_row (uint8_t* dst, uint8_t* span, const uint8_t* pixels, int width, int row,
+                                      int first, int count, uint32_t colour, int scale)
+{
+    const int stride = width/8; /* bytes per vram row */
+    const int span_len = count * scale * screen_bypp;
+
+    /* the last bit column of the vram is the top row of the screen */
+    const int col = width - 1 - row;
+
+    dst += (row * scale * screen_pitch) + (first * scale * screen_bypp);
+    blit_row (span, &pixels[first*stride + col/8], stride, count, col%8, colour, scale);
+    for (int k = 0; k < scale; ++k) {
+        memcpy (dst, span, span_len);
+        dst += screen_pitch;
+    }
+}
+
+/* Return a mask with bit n set if byte n of the two 16 byte half vram rows differ */
+static inline uint32_t vram_half_row_diff (const uint8_t* a, const uint8_t* b)
+{
+#if defined(__SSE2__)
+    const v16qi_t va = *(const v16qi_t*)a;
+    const v16qi_t vb = *(const v16qi_t*)b;
+    return (~(uint32_t)__builtin_ia32_pmovmskb128 (va == vb)) & 0xffff;
+#else
+    const uint32_t* wa = (const uint32_t*)a;
+    const uint32_t* wb = (const uint32_t*)b;
+    uint32_t diff = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint32_t x = wa[i] ^ wb[i];
+        if (x) {
+            for (int j = 0; j < 4; ++j) {
+                if (x & (0xffu << (j*8))) {
+                    diff |= 1u << (i*4 + j);
+                }
+            }
+        }
+    }
+    return diff;
+#endif
+}
+
+/* Redraw the parts of one half of the game that changed since it was last
+   drawn. The top half of the screen is held in the last 16 bytes of each vram
+   row and the bottom half in the first 16 bytes. Each half row is compared
+   with the copy taken when it was last drawn, this gives the range of changed
+   screen columns and the set of changed vram byte columns, each of which is 8
+   screen rows. Only those screen rows are redrawn and only between the first
+   and last changed column, a static screen costs no more than the compare.
+*/
+static void graphics_update (struct graphics_view* view, const uint8_t* pixels, const int half)
+{
+    const int width = i8080_VRAM_WIDTH;
+    const int height = i8080_VRAM_HEIGHT;
+    const int half_bytes = i8080_VRAM_STRIDE/2;
+    const int byte_off = (half == SCREEN_HALF_TOP) ? half_bytes : 0;
+    uint32_t dirty = 0;
+    int first = height;
+    int last = -1;
+
+    if (blit_row == NULL || view->pos.x < 0 || view->pos.y < 0) {
+        return;
+    }
+
+    /* each page is compared with what was last drawn on it */
+    uint8_t* prev = view->vram_prev[draw_page];
+
+    if (!view->vram_prev_valid[draw_page][half]) {
+        for (int i = 0; i < height; ++i) {
+            const int off = i * i8080_VRAM_STRIDE + byte_off;
+            memcpy (&prev[off], &pixels[off], half_bytes);
+        }
+        view->vram_prev_valid[draw_page][half] = true;
+        /* draw the whole half the first time */
+        dirty = 0xffff;
+        first = 0;
+        last = height - 1;
+    } else {
+        for (int i = 0; i < height; ++i) {
+            const int off = i * i8080_VRAM_STRIDE + byte_off;
+            uint32_t diff = vram_half_row_diff (&pixels[off], &prev[off]);
+            if (diff) {
+                dirty |= diff;
+                first = (i < first) ? i : first;
+                last = i;
+                memcpy (&prev[off], &pixels[off], half_bytes);
+            }
+        }
+    }
+
+    if (dirty) {
+        uint8_t* dst = screen_fb + (view->pos.y * screen_pitch) + (view->pos.x * screen_bypp);
+        const int count = last - first + 1;
+        const int first_row = (half == SCREEN_HALF_TOP) ? 0 : width/2;
+        for (int row = first_row; row < (first_row + width/2); ++row) {
+            const int col = width - 1 - row;
+            if (dirty & (1u << (col/8 - byte_off))) {
+                graphics_draw_row (dst, view->span, pixels, width, row, first, count, row_colour[row], game_scale);
+                view->diff_pixels_drawn += count;
             }
         }
     }
 
-    timer_init (120);  /* ~8.33mS */
+    /* only the first view reports, the others are drawn by other CPUs */
+    if (half == SCREEN_HALF_BOTTOM && ++view->diff_frames == DIFF_REPORT_FRAMES) {
+        const unsigned long total = (unsigned long)DIFF_REPORT_FRAMES * width * height;
+        if (view == &views[0]) {
+            printf ("render: skipped %u%% of pixels over %u frames\n",
+                    (unsigned)(((total - view->diff_pixels_drawn) * 100) / total), view->diff_frames);
+        }
+        view->diff_frames = 0;
+        view->diff_pixels_drawn = 0;
+    }
 }
 
-static inline bool get_pixel (uint8_t* pixels, const int row, const int col, const int width)
+/* Rasterise the Space Invaders font from the ROM into glyph_tiles. Like the
+   game the font data is rotated -90 degrees, each bit column of a character
+   becomes one row of its tile.
+*/
+static void graphics_load_font (void)
 {
-    int idx = (row*width/8)+(col/8);
-    uint8_t buf = pixels[idx];
-    return ((buf >> ((row*width+col) % 8)) & 1);
+    const uint8_t* font = &i8080_state_ptr->mem[i8080_FONT_DATA_ADDR];
+
+    if (blit_row == NULL) {
+        return;
+    }
+
+    for (unsigned i = 0; i < NR_GLYPHS; ++i) {
+        const uint8_t* pixels = font + font_table[i].offset;
+        for (int row = 0; row < i8080_FONT_HEIGHT; ++row) {
+            const int col = i8080_FONT_WIDTH - 1 - row;
+            blit_row (glyph_tiles[i][row], pixels, 1, i8080_FONT_WIDTH, col, yellow_px, 1);
+        }
+    }
 }
 
-static inline void set_pixel (uint32_t* pixels, const int row, const int col, const uint32_t colour)
+/* Copy the tile of character 'c' to 'pos' on the page 'fb' */
+static inline void graphics_draw_glyph (uint8_t* fb, const int c, const point_t pos)
 {
-    pixels[row*screen_width + col] = colour;
+    const uint8_t ascii_mask = 0x7f; /* 0...127 */
+    const int len = i8080_FONT_WIDTH * screen_bypp;
+    uint8_t (*tile)[GLYPH_ROW_BYTES] = glyph_tiles[font_map[c & ascii_mask]];
+    uint8_t* dst = fb + (pos.y * screen_pitch) + (pos.x * screen_bypp);
+
+    for (int row = 0; row < i8080_FONT_HEIGHT; ++row) {
+        memcpy (dst, tile[row], len);
+        dst += screen_pitch;
+    }
 }
 
-/* Copy the pixel data from the i8080 vram buffer to the screen frame buffer.
-   While copying the vram data is rotated -90 degress due to the fact that the
-   origional Space Invaders hardware had the display on its side. The x_delta
-   ensures that the game is centered on the screen. Each row of the space
-   invaders pixel data is copied to each column of the screen frame buffer,
-   while converting the single bit per pixel data into 32 bits per pixel.
+/* Move the whole screen up by one line of text and clear the last line, the
+   game is then redrawn in full.
 */
-static void graphics_draw_block (uint8_t* pixels, point_t pos, int width, int height, uint32_t colour, bool center)
+static void graphics_scroll (void)
 {
-    const int scale = 1;
-    int col_shift = center ? ((screen_width/2) - (width*scale/2)) : 0;
-
-    for (int row = 0; row < height; ++row) {
-        for (int col = 0; col < width; ++col) {
-            /* Rotation of -90 degress requires copying pixel buffer rows to frame buffer columns.
-               Pixel data is read in rows from the Space Invaders VRAM buffer and copied into colums
-               in the screen frame buffer.
-            */
-            const int srow = pos.y + width-col;
-            const int scol = pos.x + col_shift + row;
-            uint32_t c = get_pixel (pixels, row, col, width) ? colour : 0;
-
-            set_pixel (screen_fb, srow, scol, c);
+    const int len = (screen_height - LINE_HEIGHT) * screen_pitch;
+
+    for (int page = 0; page < (page_flip ? 2 : 1); ++page) {
+        uint8_t* fb = page_flip ? page_fb[page] : screen_fb;
+        memmove (fb, fb + (LINE_HEIGHT * screen_pitch), len);
+        memset (fb + len, 0, LINE_HEIGHT * screen_pitch);
+        for (int i = 0; i < nr_views; ++i) {
+            views[i].vram_prev_valid[page][SCREEN_HALF_TOP] = false;
+            views[i].vram_prev_valid[page][SCREEN_HALF_BOTTOM] = false;
         }
     }
 }
 
-static void graphics_update (void)
+/* display a character at text column 'col' of text line 'line' without
+   moving the cursor
+*/
+void graphics_draw_char (const int col, const int line, const int c)
 {
-    uint8_t* pixels = &i8080_state_ptr->mem[i8080_VRAM_BUFFER_ADDR];
-    point_t pos = {.x = 0, .y = 0};
-    int width = i8080_VRAM_WIDTH;
-    int height = i8080_VRAM_HEIGHT;
+    point_t pos = {.x = col * i8080_FONT_WIDTH, .y = line * LINE_HEIGHT};
 
-    graphics_draw_block (pixels, pos, width, height, WHITE, true);
+    if (blit_row == NULL ||
+        (pos.x + i8080_FONT_WIDTH) > screen_width || (pos.y + LINE_HEIGHT) > screen_height) {
+        return;
+    }
+
+    for (int page = 0; page < (page_flip ? 2 : 1); ++page) {
+        graphics_draw_glyph (page_flip ? page_fb[page] : screen_fb, c, pos);
+    }
 }
 
 /* display a character on the screen */
 int graphics_putchar (int c)
 {
-    int width = i8080_FONT_WIDTH;
-    int height = i8080_FONT_HEIGHT;
+    if (blit_row == NULL) {
+        return c;
+    }
 
-    if (c != '\n') {
-        const uint8_t ascii_mask = 0x7f; /* 0...127 */
-        uint8_t* pixels = &i8080_state_ptr->mem[i8080_FONT_DATA_ADDR];
+    if (c == '\n') {
+        cursor.x = 0;
+        cursor.y += LINE_HEIGHT;
+        return c;
+    }
 
-        pixels += font_table[font_map[c & ascii_mask]].offset;
+    if ((cursor.x + i8080_FONT_WIDTH) > screen_width) {
+        cursor.x = 0;
+        cursor.y += LINE_HEIGHT;
+    }
 
-        graphics_draw_block (pixels, cursor, width, height, YELLOW, false);
+    /* several newlines may have moved the cursor more than one line down */
+    while ((cursor.y + LINE_HEIGHT) > screen_height) {
+        graphics_scroll ();
+        cursor.y -= LINE_HEIGHT;
     }
 
-    if (cursor.x >= screen_width || c == '\n') {
-        cursor.y += screen_width * (width+2/* 2 pixels space between rows */);
-        cursor.x = 0;
-    } else {
-        cursor.x += width;
+    /* text is drawn on both pages so it stays on screen */
+    for (int page = 0; page < (page_flip ? 2 : 1); ++page) {
+        graphics_draw_glyph (page_flip ? page_fb[page] : screen_fb, c, cursor);
     }
+    cursor.x += i8080_FONT_WIDTH;
 
     return c;
 }
-
 int graphics_printf (const char *format, ...)
 {
     char buf[PRINT_BUF_SIZE];
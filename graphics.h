@@ -23,9 +23,28 @@
 #ifndef __GRAPHICS_H__
 #define __GRAPHICS_H__
 
+#include <stdbool.h>
+
 #include "multiboot.h"
+#include "i8080.h"
+
+#define GRAPHICS_MAX_VIEWS 16
 
 void graphics_init (multiboot_info_t *mbi, i8080_state_t* state);
+void graphics_screen_event (void);
+
+/* move rendering to another CPU (see smp.h), the timer event then only takes
+   a snapshot of the vram
+*/
+bool graphics_start_render_core (const int cpu);
+
+/* Divide the screen between 'nr' games, returns the number that fit. View 0
+   is drawn by graphics_screen_event, the others by graphics_view_event from
+   the CPU running the machine 'state'.
+*/
+int graphics_tile (int nr);
+void graphics_view_event (const int view, i8080_state_t* state);
 int graphics_printf (const char *format, ...);
+void graphics_draw_char (const int col, const int line, const int c);
 
 #endif /* __GRAPHICS_H__ */
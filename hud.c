@@ -0,0 +1,152 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "i8080.h"
+#include "stdio.h"
+#include "graphics.h"
+#include "timebase.h"
+
+#include "hud.h"
+
+#define HUD_LINES 5
+#define HUD_COLS  12
+
+/* i8080 cpu state structure */
+static i8080_state_t* i8080_state_ptr;
+
+/* only touched on the rendering CPU, F1 presses are handed over in toggle_req */
+static bool hud_enabled;
+static unsigned toggle_req;
+
+/* counters for the current one second period */
+static uint64_t period_start_ns;
+static unsigned frames;
+static uint64_t render_cycles_sum;
+static uint64_t cycles_start;
+
+/* totals since boot */
+static unsigned late_irqs;
+static unsigned dropped_irqs;
+
+/* text currently on screen, only characters that change are redrawn */
+static char shown[HUD_LINES][HUD_COLS+1];
+
+void hud_init (i8080_state_t* state)
+{
+    i8080_state_ptr = state;
+    period_start_ns = now_ns ();
+    hud_enabled = false;
+    memset (shown, ' ', sizeof(shown));
+}
+
+/* draw the characters of 'text' that differ from what is on screen */
+static void hud_draw_line (const int line, const char* text)
+{
+    bool end = false;
+    for (int i = 0; i < HUD_COLS; ++i) {
+        char c = end ? ' ' : text[i];
+        if (c == '\0') {
+            end = true;
+            c = ' ';
+        }
+        if (shown[line][i] != c) {
+            graphics_draw_char (i, line, c);
+            shown[line][i] = c;
+        }
+    }
+}
+
+static void hud_clear (void)
+{
+    for (int line = 0; line < HUD_LINES; ++line) {
+        hud_draw_line (line, "");
+    }
+}
+
+void hud_toggle (void)
+{
+    __atomic_add_fetch (&toggle_req, 1, __ATOMIC_RELAXED);
+}
+
+void hud_irq_late (void)
+{
+    late_irqs++;
+}
+
+void hud_irq_dropped (void)
+{
+    dropped_irqs++;
+}
+
+/* Accumulate the render time of each tick and once a second update the
+   overlay with the averages.
+*/
+void hud_tick (const uint64_t render_cycles, const int frame_done)
+{
+    char buf[HUD_COLS+1];
+
+    /* an even number of presses leaves the overlay as it is */
+    if (__atomic_exchange_n (&toggle_req, 0, __ATOMIC_RELAXED) & 1) {
+        hud_enabled = !hud_enabled;
+        if (!hud_enabled) {
+            hud_clear ();
+        }
+    }
+
+    render_cycles_sum += render_cycles;
+    if (frame_done) {
+        frames++;
+    }
+
+    const uint64_t now = now_ns ();
+    const uint64_t elapsed = now - period_start_ns;
+    if (elapsed < 1000000000ull) {
+        return;
+    }
+
+    const uint64_t cycles = i8080_state_ptr->cycles;
+    const unsigned fps = (unsigned)((frames * 1000000000ull) / elapsed);
+    const unsigned khz = (unsigned)(((cycles - cycles_start) * 1000000ull) / elapsed);
+    const unsigned render = frames ? (unsigned)(render_cycles_sum / frames) : 0;
+
+    if (hud_enabled) {
+        snprintf (buf, sizeof(buf), "fps %8u", fps);
+        hud_draw_line (0, buf);
+        snprintf (buf, sizeof(buf), "khz %8u", khz);
+        hud_draw_line (1, buf);
+        snprintf (buf, sizeof(buf), "rnd %8u", render);
+        hud_draw_line (2, buf);
+        snprintf (buf, sizeof(buf), "late %7u", late_irqs);
+        hud_draw_line (3, buf);
+        snprintf (buf, sizeof(buf), "drop %7u", dropped_irqs);
+        hud_draw_line (4, buf);
+    }
+
+    period_start_ns = now;
+    frames = 0;
+    render_cycles_sum = 0;
+    cycles_start = cycles;
+}
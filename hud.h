@@ -0,0 +1,45 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __HUD_H__
+#define __HUD_H__
+
+#include <stdint.h>
+
+#include "i8080.h"
+
+/* Performance overlay drawn to the left of the game, toggled with F1 */
+void hud_init (i8080_state_t* state);
+
+/* called from the main loop, takes effect on the next hud_tick */
+void hud_toggle (void);
+
+/* called on the CPU that renders, all drawing of the overlay is done here */
+void hud_tick (const uint64_t render_cycles, const int frame_done);
+
+/* called from the timer interrupt */
+void hud_irq_late (void);
+
+/* called from the emulation loop */
+void hud_irq_dropped (void);
+
+#endif /* __HUD_H__ */
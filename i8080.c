@@ -34,6 +34,26 @@
 #define i8080_TRACE(x)
 #endif
 
+/* Clock cycles per opcode, conditional calls and returns are counted as taken */
+static const uint8_t i8080_cycles[256] = {
+     4, 10,  7,  5,  5,  5,  7,  4,  4, 10,  7,  5,  5,  5,  7,  4, /* 0x00 */
+     4, 10,  7,  5,  5,  5,  7,  4,  4, 10,  7,  5,  5,  5,  7,  4, /* 0x10 */
+     4, 10, 16,  5,  5,  5,  7,  4,  4, 10, 16,  5,  5,  5,  7,  4, /* 0x20 */
+     4, 10, 13,  5, 10, 10, 10,  4,  4, 10, 13,  5,  5,  5,  7,  4, /* 0x30 */
+     5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, /* 0x40 */
+     5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, /* 0x50 */
+     5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, /* 0x60 */
+     7,  7,  7,  7,  7,  7,  7,  7,  5,  5,  5,  5,  5,  5,  7,  5, /* 0x70 */
+     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, /* 0x80 */
+     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, /* 0x90 */
+     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, /* 0xa0 */
+     4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, /* 0xb0 */
+    11, 10, 10, 10, 17, 11,  7, 11, 11, 10, 10, 10, 17, 17,  7, 11, /* 0xc0 */
+    11, 10, 10, 10, 17, 11,  7, 11, 11, 10, 10, 10, 17, 17,  7, 11, /* 0xd0 */
+    11, 10, 10, 18, 17, 11,  7, 11, 11,  5, 10,  5, 17, 17,  7, 11, /* 0xe0 */
+    11, 10, 10,  4, 17, 11,  7, 11, 11,  5, 10,  4, 17, 17,  7, 11, /* 0xf0 */
+};
+
 i8080_state_t* i8080_init (i8080_state_t* state, uint8_t* ram, const int sizeb)
 {
     if (state != NULL) {
@@ -52,9 +72,15 @@ void i8080_set_pc (i8080_state_t* state, uint16_t pc)
     state->pc = pc;
 }
 
-void i8080_set_io_handler (i8080_state_t* state, i8080_io_fn_t io_func)
+void i8080_set_io (i8080_state_t* state, const i8080_io_t* io)
 {
-    state->io_handler = io_func;
+    state->io = io;
+}
+
+void i8080_set_input_ports (i8080_state_t* state, const uint8_t* ports, const int nr)
+{
+    state->in_ports = ports;
+    state->nr_in_ports = nr;
 }
 
 void i8080_set_instr_handler (i8080_state_t* state, i8080_instr_fn_t instr_func)
@@ -363,6 +389,8 @@ int i8080_exec (i8080_state_t* state)
         }
     }
 
+    state->cycles += i8080_cycles[state->mem[state->pc]];
+
     switch (state->mem[state->pc]) {
         case 0x7f: case 0x78: case 0x79:
         case 0x7a: case 0x7b: case 0x7c:
@@ -1297,8 +1325,10 @@ int i8080_exec (i8080_state_t* state)
             uint8_t port = state->mem[state->pc+1];
             i8080_TRACE(printf ("0x%04x: in 0x%02x\n", state->pc, port));
 
-            if (state->io_handler) {
-                state->a = state->io_handler (port, 0xee, DEVICE_IN);
+            if (port < state->nr_in_ports) {
+                state->a = state->in_ports[port];
+            } else if (state->io) {
+                state->a = state->io->in[port] (state, port);
             }
 
             state->pc += 2;
@@ -1308,8 +1338,8 @@ int i8080_exec (i8080_state_t* state)
             uint8_t port = state->mem[state->pc+1];
             i8080_TRACE(printf ("0x%04x: out 0x%02x\n", state->pc, port));
 
-            if (state->io_handler) {
-                state->io_handler (port, state->a, DEVICE_OUT);
+            if (state->io) {
+                state->io->out[port] (state, port, state->a);
             }
 
             state->pc += 2;
@@ -1335,6 +1365,7 @@ void i8080_interrupt (i8080_state_t* state, uint8_t nnn)
         state->i = 0; /* disable interrupts */
         state->sp -= 2;
         state->pc = (nnn * 8);
+        state->cycles += 11; /* same as RST */
     }
 }
 
@@ -25,14 +25,21 @@
 
 #include <stdint.h>
 
-#define DEVICE_IN  0
-#define DEVICE_OUT 1
+#define i8080_RAM_SIZE (64*1024) /* 64kiB */
 
 struct i8080_state;
 
-typedef uint8_t (*i8080_io_fn_t)(const uint8_t port, const uint8_t byte, const int direction);
+typedef uint8_t (*i8080_in_fn_t)(struct i8080_state* state, const uint8_t port);
+typedef void (*i8080_out_fn_t)(struct i8080_state* state, const uint8_t port, const uint8_t byte);
 typedef int (*i8080_instr_fn_t)(struct i8080_state* state);
 
+/* IN and OUT handlers, one per port */
+typedef struct i8080_io
+{
+    i8080_in_fn_t in[256];
+    i8080_out_fn_t out[256];
+} i8080_io_t;
+
 /* 7 6 5 4 3 2 1 0
    S Z I H - P - C
 */
@@ -60,18 +67,24 @@ typedef struct i8080_state
     flags_t f;
     uint8_t* mem;
     int mem_sizeb;
-    i8080_io_fn_t io_handler;
+    const i8080_io_t* io;
+    const uint8_t* in_ports; /* IN from ports below nr_in_ports is a load */
+    int nr_in_ports;
+    void* io_ctx; /* machine specific io state */
     i8080_instr_fn_t instr_func;
     unsigned irq_set_cnt;
     unsigned irq_clr_cnt;
     int halt_req;
+    uint64_t cycles; /* clock cycles executed */
 } i8080_state_t;
 
 i8080_state_t* i8080_init (i8080_state_t* state, uint8_t* ram, const int sizeb);
 int i8080_exec (i8080_state_t* state);
 
 void i8080_set_pc (i8080_state_t* state, uint16_t pc);
-void i8080_set_io_handler (i8080_state_t* state, i8080_io_fn_t io_func);
+void i8080_set_io (i8080_state_t* state, const i8080_io_t* io);
+/* 'ports' holds the values read from ports 0 ... nr-1 */
+void i8080_set_input_ports (i8080_state_t* state, const uint8_t* ports, const int nr);
 void i8080_set_instr_handler (i8080_state_t* state, i8080_instr_fn_t instr_func);
 void i8080_load_memory (i8080_state_t* state, const int offset, uint8_t* buffer, const int len);
 void i8080_interrupt (i8080_state_t* state, uint8_t nnn);
@@ -0,0 +1,134 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "i8080.h"
+#include "invaders_io.h"
+#include "graphics.h"
+#include "smp.h"
+#include "timebase.h"
+#include "timer.h"
+#include "pmm.h"
+#include "arena.h"
+
+#include "instance.h"
+
+/* instructions executed between checks of the TSC */
+#define POLL_INSTRUCTIONS 32
+
+typedef struct instance {
+    i8080_state_t state;
+    invaders_io_t io;
+} instance_t;
+
+/* machine 0 belongs to main.c, these entries are unused */
+static instance_t instances[MAX_INSTANCES];
+
+/* 8080 memory of the machines */
+static arena_t ram_arena;
+
+static int nr_instances = 1;
+static int next_instance;
+
+/* TSC ticks between screen events */
+static uint64_t event_ticks;
+
+/* Run one machine on this CPU. There is no timer interrupt here, the screen
+   events are taken when the TSC passes the next deadline.
+*/
+static void instance_main (void)
+{
+    const int n = __atomic_fetch_add (&next_instance, 1, __ATOMIC_RELAXED);
+    i8080_state_t* state = &instances[n].state;
+    uint64_t next_event = rdtsc () + event_ticks;
+    int count = 0;
+
+    while (!i8080_exec (state)) {
+        if (++count < POLL_INSTRUCTIONS) {
+            continue;
+        }
+        count = 0;
+
+        const uint64_t now = rdtsc ();
+        if ((int64_t)(now - next_event) < 0) {
+            continue;
+        }
+        next_event += event_ticks;
+        if ((int64_t)(next_event - now) <= 0) {
+            next_event = now + event_ticks;
+        }
+
+        graphics_view_event (n, state);
+
+        /* odd events are mid screen, even events are end of screen */
+        const int rst = ((state->irq_clr_cnt + 1) & 1) ? 1 : 2;
+        i8080_interrupt (state, rst);
+        state->irq_clr_cnt++;
+    }
+
+    for (;;) {
+        asm volatile ("cli; hlt");
+    }
+}
+
+int instance_start (uint8_t* image, const int image_len, const int nr)
+{
+    event_ticks = timebase_ns_to_ticks (VIDEO_FRAME_NS / 2);
+
+    int nr_ram = (nr < MAX_INSTANCES) ? nr : MAX_INSTANCES;
+    while (nr_ram > 1 && !arena_init (&ram_arena, "instances", (nr_ram - 1) * i8080_RAM_SIZE)) {
+        nr_ram--;
+    }
+
+    for (int i = 1; i < nr_ram; ++i) {
+        i8080_state_t* state = &instances[i].state;
+        uint8_t* ram = arena_alloc (&ram_arena, i8080_RAM_SIZE, PAGE_SIZE);
+
+        i8080_init (state, ram, i8080_RAM_SIZE);
+        i8080_load_memory (state, 0x000, image, image_len);
+        io_init (&instances[i].io, state);
+    }
+
+    next_instance = 1;
+    nr_instances = 1;
+    for (int cpu = 0; nr_instances < nr_ram; ++cpu) {
+        if (!smp_start_cpu (cpu, instance_main)) {
+            break;
+        }
+        nr_instances++;
+    }
+
+    printf ("Running %u machines\n", nr_instances);
+
+    return nr_instances;
+}
+
+void instance_stop (void)
+{
+    for (int i = 1; i < nr_instances; ++i) {
+        instances[i].state.halt_req = 1;
+    }
+}
@@ -0,0 +1,42 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __INSTANCE_H__
+#define __INSTANCE_H__
+
+#include <stdint.h>
+
+#include "graphics.h"
+
+#define MAX_INSTANCES GRAPHICS_MAX_VIEWS
+
+/* Start machines 1 ... nr-1 running 'image', one on each of the other CPUs
+   (see smp.h) and each drawn in its own graphics view. Machine 0 is the one
+   run by the boot CPU. Returns the number of machines running, including
+   machine 0.
+*/
+int instance_start (uint8_t* image, const int image_len, const int nr);
+
+/* halt all the machines started by instance_start */
+void instance_stop (void);
+
+#endif /* __INSTANCE_H__ */
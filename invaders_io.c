@@ -21,10 +21,15 @@
 */
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include "i8080.h"
 #include "stdio.h"
+#include "hud.h"
+#include "sound.h"
+#include "cmdline.h"
 
 #include "invaders_io.h"
 
@@ -43,203 +48,314 @@
 #define PORT5_FLEET_4 0x08 /* SX9  7.raw */
 #define PORT5_UFO_HIT 0x10 /* SX10 8.raw */
 
-struct input_ports
-{
-    /* port 0 */
-    unsigned dip4:1;    /* power up self-test */
-    unsigned bit01:1;   /* always 1 */
-    unsigned bit02:1;   /* always 1 */
-    unsigned bit03:1;   /* always 1 */
-    unsigned fire:1;
-    unsigned left:1;
-    unsigned right:1;
-    unsigned bit07:1;   /* MYSTERY? */
-    /* port 1 */
-    unsigned credit:1;
-    unsigned p2:1;      /* Player 2 start */
-    unsigned p1:1;      /* Player 1 start */
-    unsigned bit13:1;   /* always 1 */
-    unsigned p1shot:1;
-    unsigned p1left:1;
-    unsigned p1right:1;
-    unsigned bit17:1;   /* MYSTERY? */
-    /* port 2 */
-    unsigned dip3:1;
-    unsigned dip5:1;
-    unsigned tilt:1;
-    unsigned dip6:1;
-    unsigned p2shot:1;
-    unsigned p2left:1;
-    unsigned p2right:1;
-    unsigned dip7:1;    /* Coin info in demo screen */
-} inputs;
-
-/* i8080 cpu state structure */
+/* keys that are not 8080 inputs, in the mask of KEYMAP_FN entries */
+#define KEYMAP_FN      3
+#define KEYMAP_FN_HALT 0x01
+#define KEYMAP_FN_HUD  0x02
+
+/* what a key does: sets 'mask' in input port 'port' while held, or a
+   KEYMAP_FN function, nothing when mask is 0
+*/
+typedef struct key_map {
+    uint8_t port;
+    uint8_t mask;
+} key_map_t;
+
+typedef struct key_binding {
+    const char* name;
+    key_map_t map;
+    key_t key;
+} key_binding_t;
+
+static const key_binding_t default_bindings[] = {
+    {"credit",  {1, 0x01}, KEY_5},
+    {"p2",      {1, 0x02}, KEY_2},
+    {"p1",      {1, 0x04}, KEY_1},
+    {"p1shot",  {1, 0x10}, KEY_SPACE},
+    {"p1shot",  {1, 0x10}, KEY_CONTROL},
+    {"p1left",  {1, 0x20}, KEY_LEFT},
+    {"p1right", {1, 0x40}, KEY_RIGHT},
+    {"tilt",    {2, 0x04}, KEY_T},
+    {"p2shot",  {2, 0x10}, KEY_W},
+    {"p2left",  {2, 0x20}, KEY_A},
+    {"p2right", {2, 0x40}, KEY_D},
+    {"halt",    {KEYMAP_FN, KEYMAP_FN_HALT}, KEY_ESCAPE},
+    {"hud",     {KEYMAP_FN, KEYMAP_FN_HUD},  KEY_F1},
+};
+
+#define NR_DEFAULT_BINDINGS (sizeof(default_bindings)/sizeof(default_bindings[0]))
+
+/* indexed by key code */
+static key_map_t key_map[KEY_CODES];
+
+/* machine receiving keyboard input */
 static i8080_state_t* i8080_state_ptr;
 
-void io_init (i8080_state_t* state)
+/* keys do not change the input ports */
+static bool inputs_locked;
+
+/*
+  Space Invaders 8080's read ports:
+     Read
+        00 INPUTS (Mapped in hardware but never used by the code)
+        01 INPUTS
+        02 INPUTS
+        03 bit shift register read
+
+  Ports 0...2 are the bytes in union input_ports, read directly by the 8080
+  core, the rest go through the handler table.
+*/
+#define NR_INPUT_PORTS 3
+
+static uint8_t io_in_shift (i8080_state_t* state, const uint8_t port)
 {
-    i8080_state_ptr = state;
+    const invaders_io_t* io = state->io_ctx;
+
+    (void)port;
+    return ((io->shift_reg >> (8 - io->shift_off)) & 0xff);
+}
 
-    memset (&inputs, 0, sizeof (struct input_ports));
+static uint8_t io_in_unknown (i8080_state_t* state, const uint8_t port)
+{
+    printf ("[error] unknown input port: %02x\n", port);
+    state->halt_req = 1;
+    return 0;
+}
+
+/*
+  Space Invaders 8080's write ports:
+     Write
+        02 shift amount (3 bits)
+        03 sound bits
+        04 shift data
+        05 sound bits
+        06 watch-dog
+*/
+static void io_out_shift_amount (i8080_state_t* state, const uint8_t port, const uint8_t byte)
+{
+    invaders_io_t* io = state->io_ctx;
+
+    (void)port;
+    io->shift_off = (byte & 0x7);
+}
+
+/* shift x -> y and byte -> x */
+static void io_out_shift_data (i8080_state_t* state, const uint8_t port, const uint8_t byte)
+{
+    invaders_io_t* io = state->io_ctx;
 
-    inputs.bit01 = 1; /* always 1 */
-    inputs.bit02 = 1; /* always 1 */
-    inputs.bit03 = 1; /* always 1 */
-    inputs.bit13 = 1; /* always 1 */
+    (void)port;
+    io->shift_reg >>= 8;
+    io->shift_reg |= (byte << 8);
+}
+
+/*
+  port 3:
+    bit 0=UFO (repeats) SX0 0.raw
+    bit 1=Shot SX1 1.raw
+    bit 2=Flash (player die) SX2 2.raw
+    bit 3=Invader die SX3 3.raw
+    bit 4=Extended play SX4
+    bit 5= AMP enable SX5
+    bit 6= NC (not wired)
+    bit 7= NC (not wired)
+  port 5:
+    bit 0=Fleet movement 1 SX6 4.raw
+    bit 1=Fleet movement 2 SX7 5.raw
+    bit 2=Fleet movement 3 SX8 6.raw
+    bit 3=Fleet movement 4 SX9 7.raw
+    bit 4=UFO Hit SX10 8.raw
+    bit 5= NC (Cocktail mode control ... to flip screen)
+    bit 6= NC (not wired)
+    bit 7= NC (not wired)
+*/
+static void io_out_sound (i8080_state_t* state, const uint8_t port, const uint8_t byte)
+{
+    if (state == i8080_state_ptr) {
+        sound_port (port, byte);
+    }
+}
+
+/* Watchdog, read/write to reset */
+static void io_out_watchdog (i8080_state_t* state, const uint8_t port, const uint8_t byte)
+{
+    /* Not implemented. */
+    (void)state;
+    (void)port;
+    (void)byte;
+}
+
+static void io_out_unknown (i8080_state_t* state, const uint8_t port, const uint8_t byte)
+{
+    (void)byte;
+    printf ("[error] unknown output port: %02x\n", port);
+    state->halt_req = 1;
+}
+
+/* shared by all the machines */
+static i8080_io_t invaders_ports;
+
+static void io_ports_init (void)
+{
+    for (int port = 0; port < 256; ++port) {
+        invaders_ports.in[port] = io_in_unknown;
+        invaders_ports.out[port] = io_out_unknown;
+    }
+    invaders_ports.in[3] = io_in_shift;
+    invaders_ports.out[2] = io_out_shift_amount;
+    invaders_ports.out[3] = io_out_sound;
+    invaders_ports.out[4] = io_out_shift_data;
+    invaders_ports.out[5] = io_out_sound;
+    invaders_ports.out[6] = io_out_watchdog;
+}
+
+void io_init (invaders_io_t* io, i8080_state_t* state)
+{
+    union input_ports* inputs = &io->inputs;
+
+    memset (io, 0, sizeof (invaders_io_t));
+    state->io_ctx = io;
+
+    inputs->bit01 = 1; /* always 1 */
+    inputs->bit02 = 1; /* always 1 */
+    inputs->bit03 = 1; /* always 1 */
+    inputs->bit13 = 1; /* always 1 */
     /* Dip3Dip5: 0b00 => 3 ships
                  0b01 => 4 ships
                  0b10 => 5 ships
                  0b11 => 6 ships
     */
-    inputs.dip3 = 1;
-    inputs.dip5 = 1;
+    inputs->dip3 = 1;
+    inputs->dip5 = 1;
     /* Dip6: 0 => extra ship at 1500, 1 => extra ship at 1000 */
-    inputs.dip6 = 1;
+    inputs->dip6 = 1;
+
+    if (invaders_ports.in[0] == NULL) {
+        io_ports_init ();
+    }
+    i8080_set_io (state, &invaders_ports);
+    i8080_set_input_ports (state, inputs->port, NR_INPUT_PORTS);
 }
 
-uint8_t io_handler (const uint8_t port, const uint8_t byte, const int direction)
+void io_set_focus (i8080_state_t* state)
 {
-    static uint16_t shift_reg = 0;
-    static int shift_off = 0;
-    uint8_t ret = 0;
-
-    if (direction == DEVICE_IN) {
-        /*
-          Space Invaders 8080's read ports:
-             Read
-                00 INPUTS (Mapped in hardware but never used by the code)
-                01 INPUTS
-                02 INPUTS
-                03 bit shift register read
-        */
-        switch (port) {
-            case 0: {
-                /* unused port */
-                break;
-            }
-            case 1: {
-                ret = ((inputs.credit  << 0) | (inputs.p2     << 1) | (inputs.p1     << 2) |
-                       (inputs.bit13   << 3) | (inputs.p1shot << 4) | (inputs.p1left << 5) |
-                       (inputs.p1right << 6) | (inputs.bit17  << 7));
-                break;
-            }
-            case 2: {
-                ret = ((inputs.dip3    << 0) | (inputs.dip5   << 1) | (inputs.tilt   << 2) |
-                       (inputs.dip6    << 3) | (inputs.p2shot << 4) | (inputs.p2left << 5) |
-                       (inputs.p2right << 6) | (inputs.dip7   << 7));
-                break;
-            }
-            case 3: {
-                ret = ((shift_reg >> (8 - shift_off)) & 0xff);
-                break;
-            }
-            default: {
-                printf ("[error] unknown input port: %02x\n", port);
-                i8080_state_ptr->halt_req = 1;
-            }
-        }
-    } else { // DEVICE_OUT
-        /*
-          Space Invaders 8080's write ports:
-             Write
-                02 shift amount (3 bits)
-                03 sound bits
-                04 shift data
-                05 sound bits
-                06 watch-dog
-        */
-        switch (port) {
-            case 2: {
-                shift_off = (byte & 0x7);
-                break;
-            }
-            case 3: {
-                /*
-                  bit 0=UFO (repeats) SX0 0.raw
-                  bit 1=Shot SX1 1.raw
-                  bit 2=Flash (player die) SX2 2.raw
-                  bit 3=Invader die SX3 3.raw
-                  bit 4=Extended play SX4
-                  bit 5= AMP enable SX5
-                  bit 6= NC (not wired)
-                  bit 7= NC (not wired)
-                 */
-                /* Not implemented. */
-                break;
-            }
-            case 4: { // shift x -> y and byte -> x
-                shift_reg >>= 8;
-                shift_reg |= (byte << 8);
-                break;
-            }
-            case 5: {
-                /*
-                  bit 0=Fleet movement 1 SX6 4.raw
-                  bit 1=Fleet movement 2 SX7 5.raw
-                  bit 2=Fleet movement 3 SX8 6.raw
-                  bit 3=Fleet movement 4 SX9 7.raw
-                  bit 4=UFO Hit SX10 8.raw
-                  bit 5= NC (Cocktail mode control ... to flip screen)
-                  bit 6= NC (not wired)
-                  bit 7= NC (not wired)
-                 */
-                /* Not implemented. */
-                break;
-            }
-            case 6: {
-                /* Watchdog, read/write to reset */
-                /* Not implemented. */
-                break;
-            }
-            default: {
-                printf ("[error] unknown output port: %02x\n", port);
-                i8080_state_ptr->halt_req = 1;
-            }
-        }
-    }
+    i8080_state_ptr = state;
+}
 
-    return ret;
+void io_lock_inputs (const bool locked)
+{
+    inputs_locked = locked;
 }
 
 void io_keyevent_fn (const key_t key, const keyevent_t event)
 {
-    switch (key) {
-        case KEY_SPACE: {
-            inputs.p1shot = event;
-            break;
+    const key_map_t map = key_map[key & (KEY_CODES - 1)];
+
+    if (map.mask == 0 || i8080_state_ptr == NULL) {
+        /* Ignore all other keys */
+        return;
+    }
+
+    if (map.port < KEYMAP_FN) {
+        if (inputs_locked) {
+            return;
         }
-        case KEY_CONTROL: {
-            inputs.p1shot = event;
-            break;
+        invaders_io_t* io = i8080_state_ptr->io_ctx;
+        uint8_t* port = &io->inputs.port[map.port];
+
+        *port = (event == KEY_PRESS_EVENT) ? (*port | map.mask) : (*port & ~map.mask);
+    } else if (event == KEY_PRESS_EVENT) {
+        if (map.mask & KEYMAP_FN_HALT) {
+            i8080_state_ptr->halt_req = 1;
+        }
+        if (map.mask & KEYMAP_FN_HUD) {
+            hud_toggle ();
         }
-        case KEY_LEFT: {
-            inputs.p1left = event;
-            break;
+    }
+}
+
+/* bind 'key' to the input called 'name', replacing its other keys */
+static bool io_keymap_bind (const char* name, const key_t key)
+{
+    for (unsigned i = 0; i < NR_DEFAULT_BINDINGS; ++i) {
+        const key_binding_t* b = &default_bindings[i];
+
+        int c = 0;
+        while (name[c] && name[c] == b->name[c]) {
+            c++;
         }
-        case KEY_RIGHT: {
-            inputs.p1right = event;
-            break;
+        if (name[c] != b->name[c]) {
+            continue;
         }
-        case KEY_5: {
-            inputs.credit = event;
-            break;
+
+        for (unsigned k = 0; k < KEY_CODES; ++k) {
+            if (key_map[k].port == b->map.port && key_map[k].mask == b->map.mask) {
+                key_map[k].mask = 0;
+            }
         }
-        case KEY_1: {
-            inputs.p1 = event;
-            break;
+        key_map[key] = b->map;
+        return true;
+    }
+
+    return false;
+}
+
+/* hex, KEY_CODES if it is not a key code */
+static unsigned io_keymap_code (const char* p)
+{
+    unsigned code = 0;
+
+    if (*p == '\0') {
+        return KEY_CODES;
+    }
+    for (; *p && code < KEY_CODES; p++) {
+        const char c = *p;
+        if (c >= '0' && c <= '9') {
+            code = (code << 4) | (unsigned)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            code = (code << 4) | (unsigned)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            code = (code << 4) | (unsigned)(c - 'A' + 10);
+        } else {
+            return KEY_CODES;
         }
-        case KEY_2: {
-            inputs.p2 = event;
-            break;
+    }
+
+    return code;
+}
+
+void io_keymap_init (void)
+{
+    char keys[128];
+
+    memset (key_map, 0, sizeof(key_map));
+    for (unsigned i = 0; i < NR_DEFAULT_BINDINGS; ++i) {
+        key_map[default_bindings[i].key] = default_bindings[i].map;
+    }
+
+    if (!cmdline_get ("keys", keys, sizeof(keys))) {
+        return;
+    }
+
+    /* name:code[,name:code...] */
+    char* p = keys;
+    while (*p) {
+        char* name = p;
+        char* code = NULL;
+
+        for (; *p && *p != ','; p++) {
+            if (*p == ':' && code == NULL) {
+                *p = '\0';
+                code = p + 1;
+            }
         }
-        case KEY_ESCAPE: {
-            i8080_state_ptr->halt_req = 1;
-            break;
+        if (*p == ',') {
+            *p++ = '\0';
         }
-        default: {
-            /* Ignore all other keys */
-            break;
+
+        const unsigned key = code ? io_keymap_code (code) : KEY_CODES;
+        if (key >= KEY_CODES || !io_keymap_bind (name, (key_t)key)) {
+            printf ("[error] option keys: bad binding '%s'\n", name);
         }
     }
 }
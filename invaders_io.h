@@ -24,11 +24,68 @@
 #define __INVADERS_IO_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 
+#include "i8080.h"
 #include "keyboard.h"
 
-void io_init (i8080_state_t* state);
-uint8_t io_handler (const uint8_t port, const uint8_t byte, const int direction);
+/* The input ports as the 8080 reads them, bit by bit or as bytes */
+union input_ports
+{
+    struct {
+        /* port 0 */
+        unsigned dip4:1;    /* power up self-test */
+        unsigned bit01:1;   /* always 1 */
+        unsigned bit02:1;   /* always 1 */
+        unsigned bit03:1;   /* always 1 */
+        unsigned fire:1;
+        unsigned left:1;
+        unsigned right:1;
+        unsigned bit07:1;   /* MYSTERY? */
+        /* port 1 */
+        unsigned credit:1;
+        unsigned p2:1;      /* Player 2 start */
+        unsigned p1:1;      /* Player 1 start */
+        unsigned bit13:1;   /* always 1 */
+        unsigned p1shot:1;
+        unsigned p1left:1;
+        unsigned p1right:1;
+        unsigned bit17:1;   /* MYSTERY? */
+        /* port 2 */
+        unsigned dip3:1;
+        unsigned dip5:1;
+        unsigned tilt:1;
+        unsigned dip6:1;
+        unsigned p2shot:1;
+        unsigned p2left:1;
+        unsigned p2right:1;
+        unsigned dip7:1;    /* Coin info in demo screen */
+    };
+    uint8_t port[4];
+};
+
+/* io state of one Space Invaders machine */
+typedef struct invaders_io
+{
+    union input_ports inputs;
+    uint16_t shift_reg;
+    int shift_off;
+} invaders_io_t;
+
+/* reset the io state and attach it and the port handlers to 'state' */
+void io_init (invaders_io_t* io, i8080_state_t* state);
 void io_keyevent_fn (const key_t key, const keyevent_t event);
 
+/* Build the key to input port map, the defaults with any changes from the
+   "keys" option, e.g. keys=p2left:1e,p2right:20 (hex set 1 make codes,
+   0x100 added for keys with an 0xe0 prefix).
+*/
+void io_keymap_init (void);
+
+/* keyboard input goes to this machine */
+void io_set_focus (i8080_state_t* state);
+
+/* ignore keys mapped to input ports, e.g. while replaying a movie */
+void io_lock_inputs (const bool locked);
+
 #endif // __INVADERS_IO_H__
@@ -25,111 +25,96 @@
 #include <stdbool.h>
 
 #include "x86.h"
+#include "stdio.h"
+#include "timebase.h"
 
 #include "keyboard.h"
 
-struct key {
-    uint16_t code;
-    unsigned press_cnt;
-    unsigned release_cnt;
-};
-
-static struct key key_table[] = {
-    {KEY_SPACE,   0, 0},
-    {KEY_CONTROL, 0, 0},
-    {KEY_LEFT,    0, 0},
-    {KEY_RIGHT,   0, 0},
-    {KEY_5,       0, 0},
-    {KEY_1,       0, 0},
-    {KEY_2,       0, 0},
-    {KEY_ESCAPE,  0, 0},
-};
-
-static uint32_t keycode;
+/* must be a power of 2 */
+#define KEY_QUEUE_SIZE 64
 
-static key_event_handler_t key_event_handler;
-
-static inline bool is_2byte_key (const uint8_t key)
-{
-    return (key == 0xe0);
-}
-
-static inline struct key* find_key (const uint16_t keycode)
-{
-    for (unsigned i = 0; i < (sizeof(key_table)/sizeof(key_table[0])); ++i) {
-        if ((keycode & ~0x80) == key_table[i].code) {
-            return &key_table[i];
-        }
-    }
-    return NULL;
-}
+/* KEY_EXTENDED after an 0xe0 prefix byte */
+static uint16_t extended;
 
-static inline int count_pressed (void)
-{
-    int count = 0;
-    for (unsigned i = 0; i < (sizeof(key_table)/sizeof(key_table[0])); ++i) {
-        if (key_table[i].press_cnt > key_table[i].release_cnt) {
-            count++;
-        }
-    }
-    return count;
-}
-
-static inline bool is_key_release (const uint16_t keycode)
-{
-    return ((keycode & 0x80) != 0);
-}
+static key_event_handler_t key_event_handler;
 
+/* Scancodes with the TSC at which they arrived. The interrupt handler is the
+   only writer of queue_head and keyboard_poll the only writer of queue_tail,
+   the indices run freely and are masked on use.
+*/
+typedef struct key_queue_entry {
+    uint64_t tsc;
+    key_t key;
+    keyevent_t event;
+} key_queue_entry_t;
+
+static key_queue_entry_t key_queue[KEY_QUEUE_SIZE];
+static unsigned queue_head;
+static unsigned queue_tail;
+
+/* statistics */
+static unsigned queue_overflows;
+static unsigned key_events;
+static uint64_t latency_sum_ns;
+static uint64_t latency_max_ns;
+
+/* IRQ 1, only queues the key, see keyboard_poll */
 void keyboard_irq_handler (void)
 {
     uint8_t status = inport8 (0x64);
     if (status & 1) {
         uint8_t k = inport8 (0x60);
 
-        keycode <<= 8;
-        keycode |= k;
-
-        if (is_2byte_key(k)) {
+        if (k == 0xe0) {
             /* wait for second keycode byte */
+            extended = KEY_EXTENDED;
             return;
         }
 
-        struct key* key = find_key (keycode);
-        if (key == NULL) {
-            /* ignore all other keys */
-            keycode = 0;
-            return;
-        }
-
-        if (is_key_release(keycode)) {
-            key->release_cnt++;
+        const unsigned head = queue_head;
+        if ((head - __atomic_load_n (&queue_tail, __ATOMIC_ACQUIRE)) < KEY_QUEUE_SIZE) {
+            key_queue_entry_t* e = &key_queue[head & (KEY_QUEUE_SIZE - 1)];
+            e->tsc = rdtsc ();
+            e->key = extended | (k & 0x7f);
+            e->event = (k & 0x80) ? KEY_RELEASE_EVENT : KEY_PRESS_EVENT;
+            __atomic_store_n (&queue_head, head + 1, __ATOMIC_RELEASE);
         } else {
-            key->press_cnt++;
+            queue_overflows++;
         }
 
-        if (count_pressed() > 1) {
-            /* missed release events: release all */
-            for (unsigned i = 0; i < (sizeof(key_table)/sizeof(key_table[0])); ++i) {
-                if (key_table[i].press_cnt > key_table[i].release_cnt) {
-                    key_event_handler (key_table[i].code, KEY_RELEASE_EVENT);
-                    key_table[i].press_cnt = key_table[i].release_cnt;
-                }
-            }
-
-            if (!is_key_release(keycode)) {
-                key->press_cnt++;
-            }
-        }
+        extended = 0;
+    }
+}
 
-        /* normal press/release */
-        if (is_key_release (keycode)) {
-            key_event_handler (key->code, KEY_RELEASE_EVENT);
-        } else {
-            key_event_handler (key->code, KEY_PRESS_EVENT);
-        }
+void keyboard_poll (void)
+{
+    unsigned tail = queue_tail;
+    const unsigned head = __atomic_load_n (&queue_head, __ATOMIC_ACQUIRE);
+
+    if (tail == head) {
+        return;
+    }
+
+    const uint64_t now = rdtsc ();
+    for (; tail != head; ++tail) {
+        const key_queue_entry_t* e = &key_queue[tail & (KEY_QUEUE_SIZE - 1)];
+        const uint64_t latency = timebase_ticks_to_ns (now - e->tsc);
+
+        key_events++;
+        latency_sum_ns += latency;
+        latency_max_ns = (latency > latency_max_ns) ? latency : latency_max_ns;
 
-        keycode = 0;
+        key_event_handler (e->key, e->event);
     }
+    __atomic_store_n (&queue_tail, tail, __ATOMIC_RELEASE);
+}
+
+void keyboard_report (void)
+{
+    const unsigned avg_us = key_events ? (unsigned)((latency_sum_ns / key_events) / 1000) : 0;
+
+    printf ("input: %u events, latency avg %uus max %uus, %u dropped\n",
+            key_events, avg_us, (unsigned)(latency_max_ns / 1000), queue_overflows);
 }
 
 void keyboard_init (key_event_handler_t handler)
@@ -25,14 +25,23 @@
 
 #include <stdint.h>
 
-#define KEY_SPACE   0x0039
-#define KEY_CONTROL 0x001d
-#define KEY_LEFT    0xe04b
-#define KEY_RIGHT   0xe04d
-#define KEY_5       0x0006
+/* Set 1 make codes, keys sent with an 0xe0 prefix have KEY_EXTENDED set */
+#define KEY_EXTENDED 0x0100
+#define KEY_CODES    512
+
+#define KEY_ESCAPE  0x0001
 #define KEY_1       0x0002
 #define KEY_2       0x0003
-#define KEY_ESCAPE  0x0001
+#define KEY_5       0x0006
+#define KEY_W       0x0011
+#define KEY_T       0x0014
+#define KEY_CONTROL 0x001d
+#define KEY_A       0x001e
+#define KEY_D       0x0020
+#define KEY_SPACE   0x0039
+#define KEY_F1      0x003b
+#define KEY_LEFT    (KEY_EXTENDED | 0x004b)
+#define KEY_RIGHT   (KEY_EXTENDED | 0x004d)
 
 typedef uint16_t key_t;
 
@@ -45,4 +54,13 @@ typedef void (*key_event_handler_t) (const key_t key, const keyevent_t event);
 
 void keyboard_init (key_event_handler_t handler);
 
+/* The keyboard interrupt only queues scancodes. Deliver the queued key events
+   to the handler, this is called by the emulator loop between instructions so
+   the handler never runs while the 8080 is reading the input ports.
+*/
+void keyboard_poll (void);
+
+/* print the number of events and their latency from interrupt to delivery */
+void keyboard_report (void);
+
 #endif /* __KEYBOARD_H__ */
@@ -30,9 +30,19 @@
 #include "graphics.h"
 #include "keyboard.h"
 #include "bdos.h"
-
-/* i8080 hardware  */
-#define i8080_RAM_SIZE (64*1024) /* 64kiB */
+#include "hud.h"
+#include "timebase.h"
+#include "timer.h"
+#include "telemetry.h"
+#include "smp.h"
+#include "cmdline.h"
+#include "instance.h"
+#include "profile.h"
+#include "pmu.h"
+#include "boot.h"
+#include "pmm.h"
+#include "sound.h"
+#include "movie.h"
 
 /* first word of the rom images used for identification */
 #define i8080_CPUDIAG_MAGIC  0x4d01abc3
@@ -46,13 +56,21 @@ static void exec_invaders (i8080_state_t* state, uint8_t* image, int image_len);
 /* i8080 state structure and memory */
 static i8080_state_t i8080_state;
 static uint8_t i8080_ram[i8080_RAM_SIZE];
+static invaders_io_t invaders_io;
 
 /* defined in start.S */
 extern multiboot_info_t* multiboot_ptr;
 
 int main (void)
 {
+    /* queue the boot diagnostics rather than wait for the UART, they are sent
+       once interrupts are enabled
+    */
+    serial_init ();
     show_cpu_info();
+    cmdline_init (multiboot_ptr);
+    pmm_init (multiboot_ptr);
+    timebase_init();
 
     i8080_init (&i8080_state, i8080_ram, i8080_RAM_SIZE);
 
@@ -69,6 +87,7 @@ int main (void)
         break;
     default:
         printf ("[error]: unknown image specified...\n");
+        serial_flush ();
         break;
     }
 
@@ -79,8 +98,12 @@ static void exec_cpudiag (i8080_state_t* state, uint8_t* image, int image_len)
 {
     int cpudiag_load_address = 0x100;
 
+    /* interrupts are not used, write the output directly */
+    serial_flush ();
+
     printf ("Loading cpudiag...\n");
     i8080_load_memory (state, cpudiag_load_address, image, image_len);
+    boot_stamp (BOOT_ROM);
     i8080_set_pc (state, cpudiag_load_address);
     i8080_set_instr_handler (state, bdos_entry);
 
@@ -89,31 +112,102 @@ static void exec_cpudiag (i8080_state_t* state, uint8_t* image, int image_len)
     printf ("\n*** 8080 CPU HALTED ***\n");
 }
 
+/* timer interrupt, twice a frame */
+static void screen_event (void)
+{
+    sound_tick ();
+    graphics_screen_event ();
+}
+
 static void exec_invaders (i8080_state_t* state, uint8_t* image, int image_len)
 {
     int invaders_load_address = 0x000;
 
-    graphics_init (multiboot_ptr, state);
-    keyboard_init (io_keyevent_fn);
-    io_init(state);
-    i8080_set_io_handler (state, io_handler);
+    /* the ROM is loaded first, graphics_init takes the font from it */
     printf ("Loading invaders...\n");
     i8080_load_memory (state, invaders_load_address, image, image_len);
+    boot_stamp (BOOT_ROM);
+
+    graphics_init (multiboot_ptr, state);
+
+    pmu_init ();
+
+    /* either one machine per CPU or one machine with a render core */
+    const int nr_aps = smp_init ();
+    int nr_machines = cmdline_get_int ("instances", 1);
+    if (nr_machines > (nr_aps + 1)) {
+        nr_machines = nr_aps + 1;
+    }
+    if (nr_machines > 1) {
+        nr_machines = graphics_tile (nr_machines);
+        instance_start (image, image_len, nr_machines);
+    } else if (nr_aps > 0) {
+        graphics_start_render_core (0);
+    }
+
+    sound_init ();
+    timer_init (screen_event);
+    io_keymap_init ();
+    keyboard_init (io_keyevent_fn);
+    io_init (&invaders_io, state);
+    io_set_focus (state);
+    telemetry_init ();
+
+    if (cmdline_has ("profile")) {
+        profile_init (cmdline_get_int ("profile", PROFILE_DEFAULT_HZ));
+    }
+
+    /* the keyboard cannot change the inputs of a replay */
+    const movie_mode_t movie = movie_init (multiboot_ptr, state, invaders_io.inputs.port);
+    io_lock_inputs (movie == MOVIE_REPLAY);
+    uint64_t next_rst_cycles = MOVIE_HALF_FRAME_CYCLES;
 
     irq_enable();
 
     printf ("Executing 8080 image...\n");
     while (!i8080_exec (state)) {
-        if (state->irq_set_cnt != state->irq_clr_cnt) {
-            if ((state->irq_set_cnt & 1) == 0) {
-                i8080_interrupt (state, 2); /* end of screen interrupt */
-            } else {
-                i8080_interrupt (state, 1); /* mid screen interrupt */
+        if (movie != MOVIE_OFF) {
+            /* Screen interrupts at fixed cycle counts, paced by the timer.
+               The 8080 waits here if it gets to the next one early.
+            */
+            if (state->cycles < next_rst_cycles) {
+                continue;
             }
-            state->irq_clr_cnt++;
+            while (__atomic_load_n (&state->irq_set_cnt, __ATOMIC_ACQUIRE) == state->irq_clr_cnt) {
+                asm volatile ("pause");
+            }
+            next_rst_cycles += MOVIE_HALF_FRAME_CYCLES;
+        } else if (state->irq_set_cnt == state->irq_clr_cnt) {
+            continue;
+        }
+
+        /* odd events are mid screen, even events are end of screen */
+        const int rst = ((state->irq_clr_cnt + 1) & 1) ? 1 : 2;
+        if (!state->i) {
+            hud_irq_dropped (); /* interrupts disabled by the 8080 */
+        }
+        /* input changes once per screen event, once per frame with a movie */
+        if (movie == MOVIE_OFF || rst == 2) {
+            keyboard_poll ();
+        }
+        if (rst == 2 && movie != MOVIE_OFF && !movie_frame ()) {
+            break; /* end of the replay */
+        }
+        i8080_interrupt (state, rst);
+        state->irq_clr_cnt++;
+        telemetry_rst (rst, state->cycles);
+        if (rst == 2) {
+            telemetry_poll ();
         }
     }
     irq_disable();
+    sound_stop ();
+    serial_flush ();
+    instance_stop ();
+    telemetry_report ();
+    keyboard_report ();
+    profile_report ();
+    movie_report ();
     printf ("*** 8080 CPU HALTED ***\n");
     graphics_printf ("*** 8080 CPU HALTED ***\n");
 }
@@ -0,0 +1,70 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+/* Copy whole machine words with "rep movs" then the remaining bytes, this is
+   used for replicating frame buffer spans so it must be fast for large n.
+*/
+void* memcpy (void* dest, const void* src, size_t n)
+{
+    void* d = dest;
+    size_t words = n / sizeof(unsigned long);
+    size_t bytes = n % sizeof(unsigned long);
+
+#if defined(__x86_64__)
+    asm volatile ("rep movsq" : "+D" (d), "+S" (src), "+c" (words) : : "memory");
+#else
+    asm volatile ("rep movsl" : "+D" (d), "+S" (src), "+c" (words) : : "memory");
+#endif
+    asm volatile ("rep movsb" : "+D" (d), "+S" (src), "+c" (bytes) : : "memory");
+
+    return dest;
+}
+
+/* Forwards with memcpy unless dest starts inside src, then backwards a word
+   at a time. The direction flag is left clear as the interrupt handlers
+   assume it is.
+*/
+void* memmove (void* dest, const void* src, size_t n)
+{
+    if ((uintptr_t)dest - (uintptr_t)src >= n) {
+        return memcpy (dest, src, n);
+    }
+
+    uint8_t* d = (uint8_t*)dest + n;
+    const uint8_t* s = (const uint8_t*)src + n;
+    size_t words = n / sizeof(unsigned long);
+    size_t bytes = n % sizeof(unsigned long);
+
+    while (bytes--) {
+        *--d = *--s;
+    }
+    while (words--) {
+        d -= sizeof(unsigned long);
+        s -= sizeof(unsigned long);
+        *(unsigned long*)d = *(const unsigned long*)s;
+    }
+
+    return dest;
+}
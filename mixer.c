@@ -0,0 +1,183 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sound.h"
+
+#include "mixer.h"
+
+/* samples between updates of pitch and volume */
+#define MIXER_CHUNK 32
+
+typedef int16_t v8hi_t __attribute__((vector_size(16)));
+
+/* A square wave, or noise clocked at the same rate, swept linearly from
+   hz_start to hz_end with an optional triangle wave vibrato.
+*/
+typedef struct synth {
+    uint16_t hz_start;
+    uint16_t hz_end;
+    uint16_t lfo_hz;
+    uint16_t lfo_depth; /* Hz either side */
+    uint16_t ms;        /* length, 0 plays while the port bit is set */
+    uint8_t noise;
+    uint8_t decay;      /* volume falls to 0 over the length */
+    int16_t volume;
+} synth_t;
+
+/* indexed by sound bit, the nine channels of the board's discrete sound
+   circuits; extended play and amp enable make no sound of their own
+*/
+static const synth_t synths[SOUND_BITS] = {
+    [0]  = {  500,  500,  7, 180,    0, 0, 0, 3000 }, /* UFO */
+    [1]  = { 1400,  300,  0,   0,  220, 0, 1, 4000 }, /* shot */
+    [2]  = { 3000,  600,  0,   0, 1000, 1, 1, 6000 }, /* flash, player die */
+    [3]  = { 6000, 2000,  0,   0,  300, 1, 1, 5000 }, /* invader die */
+    [6]  = {   98,   90,  0,   0,  100, 0, 1, 6000 }, /* fleet movement 1 */
+    [7]  = {   87,   80,  0,   0,  100, 0, 1, 6000 }, /* fleet movement 2 */
+    [8]  = {   78,   72,  0,   0,  100, 0, 1, 6000 }, /* fleet movement 3 */
+    [9]  = {   73,   66,  0,   0,  100, 0, 1, 6000 }, /* fleet movement 4 */
+    [10] = { 1800,  600, 15, 400, 1000, 0, 0, 3500 }, /* UFO hit */
+};
+
+typedef struct voice {
+    uint32_t phase;
+    uint32_t lfo_phase;
+    uint32_t pos;       /* samples played */
+    uint32_t len;       /* samples, 0 while the port bit is set */
+    uint16_t lfsr;
+    bool on;
+} voice_t;
+
+static voice_t voices[SOUND_BITS];
+
+/* phase increment per sample for 1Hz, 0.32 fixed point */
+static uint32_t phase_per_hz;
+static unsigned sample_rate;
+
+void mixer_init (const unsigned rate)
+{
+    sample_rate = rate;
+    phase_per_hz = 0xffffffffu / rate;
+    for (int i = 0; i < SOUND_BITS; ++i) {
+        voices[i].on = false;
+    }
+}
+
+/* one chunk of a channel */
+static void synth_chunk (const synth_t* s, voice_t* v, int16_t* buf)
+{
+    int32_t hz = s->hz_start;
+    int32_t volume = s->volume;
+
+    if (v->len) {
+        hz += ((int32_t)s->hz_end - (int32_t)s->hz_start) * (int32_t)v->pos / (int32_t)v->len;
+        if (s->decay) {
+            volume = volume * (int32_t)(v->len - v->pos) / (int32_t)v->len;
+        }
+    }
+    if (s->lfo_hz) {
+        /* triangle, -32768 ... 32767 */
+        const int32_t p = (int32_t)(v->lfo_phase >> 16);
+        const int32_t tri = (p < 32768) ? (p * 2 - 32768) : (98303 - p * 2);
+        hz += (int32_t)s->lfo_depth * tri / 32768;
+        v->lfo_phase += s->lfo_hz * phase_per_hz * MIXER_CHUNK;
+    }
+    hz = (hz < 20) ? 20 : hz;
+
+    const uint32_t step = (uint32_t)hz * phase_per_hz;
+    const int16_t hi = (int16_t)volume;
+    const int16_t lo = (int16_t)-volume;
+
+    if (s->noise) {
+        for (int i = 0; i < MIXER_CHUNK; ++i) {
+            const uint32_t prev = v->phase;
+            v->phase += step;
+            if (v->phase < prev) {
+                /* 15-bit LFSR, taps 15 and 14 */
+                const uint16_t bit = ((v->lfsr >> 0) ^ (v->lfsr >> 1)) & 1;
+                v->lfsr = (uint16_t)((v->lfsr >> 1) | (bit << 14));
+            }
+            buf[i] = (v->lfsr & 1) ? hi : lo;
+        }
+    } else {
+        for (int i = 0; i < MIXER_CHUNK; ++i) {
+            buf[i] = (v->phase & 0x80000000u) ? hi : lo;
+            v->phase += step;
+        }
+    }
+
+    v->pos += MIXER_CHUNK;
+}
+
+void mixer_mix (int16_t* out, const unsigned nr_samples, const uint16_t start, const uint16_t level)
+{
+    int16_t chan[MIXER_CHUNK] __attribute__((aligned(16)));
+
+    for (int i = 0; i < SOUND_BITS; ++i) {
+        const synth_t* s = &synths[i];
+        voice_t* v = &voices[i];
+
+        if ((start & (1u << i)) && s->volume) {
+            v->phase = 0;
+            v->lfo_phase = 0;
+            v->pos = 0;
+            v->len = (uint32_t)s->ms * sample_rate / 1000;
+            v->lfsr = 0x4000;
+            v->on = true;
+        }
+        /* repeating sounds stop when the bit is cleared */
+        if (v->on && v->len == 0 && !(level & (1u << i))) {
+            v->on = false;
+        }
+    }
+
+    for (unsigned n = 0; n < nr_samples; n += MIXER_CHUNK) {
+        v8hi_t acc[MIXER_CHUNK / 8] = { { 0 } };
+
+        for (int i = 0; i < SOUND_BITS; ++i) {
+            voice_t* v = &voices[i];
+            if (!v->on) {
+                continue;
+            }
+
+            synth_chunk (&synths[i], v, chan);
+            if (v->len && v->pos >= v->len) {
+                v->on = false;
+            }
+
+            const v8hi_t* c = (const v8hi_t*)chan;
+            for (int k = 0; k < (MIXER_CHUNK / 8); ++k) {
+                acc[k] = __builtin_ia32_paddsw128 (acc[k], c[k]);
+            }
+        }
+
+        /* nothing is heard until the game enables the amplifier */
+        v8hi_t* o = (v8hi_t*)&out[n];
+        for (int k = 0; k < (MIXER_CHUNK / 8); ++k) {
+            o[k] = (level & SOUND_AMP_ENABLE) ? acc[k] : (v8hi_t){ 0 };
+        }
+    }
+}
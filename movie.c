@@ -0,0 +1,233 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "multiboot.h"
+#include "x86.h"
+#include "stdio.h"
+#include "i8080.h"
+#include "cmdline.h"
+#include "timebase.h"
+#include "arena.h"
+
+#include "movie.h"
+
+#define MOVIE_MAGIC 0x31564f4d /* "MOV1" */
+
+/* default size of the recording in KiB, "record=N" to change */
+#define MOVIE_RECORD_KB 1024
+
+/* 8080 work RAM and video RAM, hashed to check a replay */
+#define MOVIE_RAM_ADDR 0x2000
+#define MOVIE_RAM_SIZE 0x2000
+
+typedef struct movie_header {
+    uint32_t magic;
+    uint32_t nr_runs;
+    uint32_t nr_frames;
+    uint32_t ram_hash;  /* at the start of frame nr_frames */
+} movie_header_t;
+
+/* 'frames' frames from 'frame' on read the same port values */
+typedef struct movie_run {
+    uint32_t frame;
+    uint16_t frames;
+    uint8_t port1;
+    uint8_t port2;
+} movie_run_t;
+
+static movie_mode_t mode;
+static i8080_state_t* i8080_state_ptr;
+static uint8_t* in_ports;
+
+static arena_t movie_arena;
+static movie_header_t* header;
+static movie_run_t* runs;
+static uint32_t max_runs;
+
+static uint32_t frame;
+static uint32_t run;
+static uint32_t run_left;
+static uint32_t replay_hash;
+static bool replay_done;
+static uint64_t start_ns;
+
+/* FNV-1a */
+static uint32_t movie_ram_hash (void)
+{
+    const uint8_t* ram = &i8080_state_ptr->mem[MOVIE_RAM_ADDR];
+    uint32_t hash = 0x811c9dc5;
+
+    for (int i = 0; i < MOVIE_RAM_SIZE; ++i) {
+        hash = (hash ^ ram[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+static bool movie_load (multiboot_info_t* mbi)
+{
+    if (!(mbi->flags & MULTIBOOT_INFO_MODS) || mbi->mods_count < 2) {
+        return false;
+    }
+
+    const multiboot_module_t* mod = pointer_cast(multiboot_module_t*,mbi->mods_addr) + 1;
+    const uint32_t len = mod->mod_end - mod->mod_start;
+    header = pointer_cast(movie_header_t*,mod->mod_start);
+    runs = pointer_cast(movie_run_t*,mod->mod_start + sizeof(movie_header_t));
+
+    if (len < sizeof(movie_header_t) || header->magic != MOVIE_MAGIC ||
+        header->nr_runs > ((len - sizeof(movie_header_t)) / sizeof(movie_run_t))) {
+        printf ("[error] second module is not a movie\n");
+        return false;
+    }
+
+    return true;
+}
+
+movie_mode_t movie_init (multiboot_info_t* mbi, i8080_state_t* state, uint8_t* ports)
+{
+    i8080_state_ptr = state;
+    in_ports = ports;
+    frame = 0;
+    run = 0;
+    run_left = 0;
+    replay_done = false;
+    mode = MOVIE_OFF;
+
+    if (movie_load (mbi)) {
+        mode = MOVIE_REPLAY;
+        printf ("Replaying %u frames\n", header->nr_frames);
+    } else if (cmdline_has ("record")) {
+        const size_t size = (size_t)cmdline_get_int ("record", MOVIE_RECORD_KB) * 1024;
+        if (size > sizeof(movie_header_t) && arena_init (&movie_arena, "movie", size)) {
+            header = arena_alloc (&movie_arena, sizeof(movie_header_t), 4);
+            max_runs = (uint32_t)((size - sizeof(movie_header_t)) / sizeof(movie_run_t));
+            runs = arena_alloc (&movie_arena, max_runs * sizeof(movie_run_t), 4);
+            header->magic = MOVIE_MAGIC;
+            mode = MOVIE_RECORD;
+            printf ("Recording up to %u input changes\n", max_runs);
+        }
+    }
+
+    start_ns = now_ns ();
+
+    return mode;
+}
+
+static void movie_record (void)
+{
+    movie_run_t* last = header->nr_runs ? &runs[header->nr_runs - 1] : NULL;
+    const uint8_t port1 = in_ports[1];
+    const uint8_t port2 = in_ports[2];
+
+    header->nr_frames = frame;
+    header->ram_hash = movie_ram_hash ();
+
+    if (last && last->port1 == port1 && last->port2 == port2 && last->frames < 0xffff) {
+        last->frames++;
+    } else if (header->nr_runs < max_runs) {
+        movie_run_t* r = &runs[header->nr_runs++];
+        r->frame = frame;
+        r->frames = 1;
+        r->port1 = port1;
+        r->port2 = port2;
+    } else {
+        /* full, what has been recorded so far replays up to here */
+        printf ("[error] movie full at frame %u\n", frame);
+        mode = MOVIE_OFF;
+    }
+}
+
+static bool movie_replay (void)
+{
+    if (frame >= header->nr_frames) {
+        replay_hash = movie_ram_hash ();
+        replay_done = true;
+        return false;
+    }
+
+    if (run_left == 0) {
+        if (run >= header->nr_runs || runs[run].frame != frame) {
+            printf ("[error] movie has no input for frame %u\n", frame);
+            return false;
+        }
+        in_ports[1] = runs[run].port1;
+        in_ports[2] = runs[run].port2;
+        run_left = runs[run].frames;
+        run++;
+    }
+    run_left--;
+
+    return true;
+}
+
+bool movie_frame (void)
+{
+    frame++;
+
+    if (mode == MOVIE_RECORD) {
+        movie_record ();
+    } else if (mode == MOVIE_REPLAY) {
+        if (!movie_replay ()) {
+            mode = MOVIE_OFF;
+            i8080_state_ptr->halt_req = 1;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void movie_report (void)
+{
+    const uint64_t ms = (now_ns () - start_ns) / 1000000;
+
+    if (header == NULL) {
+        return;
+    }
+
+    if (movie_arena.base) {
+        /* the header and runs as hex, tools/movie.py turns this back into a file */
+        const uint8_t* p = (const uint8_t*)header;
+        const size_t len = sizeof(movie_header_t) + header->nr_runs * sizeof(movie_run_t);
+
+        printf ("movie: recorded %u frames, %u runs, RAM hash %08x\n",
+                header->nr_frames, header->nr_runs, header->ram_hash);
+        for (size_t i = 0; i < len; i += 32) {
+            printf ("movie:");
+            for (size_t j = i; j < len && j < (i + 32); ++j) {
+                printf (" %02x", p[j]);
+            }
+            printf ("\n");
+        }
+        printf ("movie: end\n");
+    } else if (replay_done) {
+        printf ("replay: %u frames in %ums, RAM hash %08x, recorded %08x, %s\n",
+                frame, (unsigned)ms, replay_hash, header->ram_hash,
+                (replay_hash == header->ram_hash) ? "match" : "MISMATCH");
+    } else {
+        printf ("replay: stopped at frame %u of %u\n", frame, header->nr_frames);
+    }
+}
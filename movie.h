@@ -0,0 +1,59 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __MOVIE_H__
+#define __MOVIE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "multiboot.h"
+#include "i8080.h"
+#include "timer.h"
+
+/* Input movies: the bytes the 8080 reads from ports 1 and 2, run length
+   encoded by frame. While recording or replaying the screen interrupts are
+   delivered at fixed 8080 cycle counts and the inputs only change at the
+   end of screen interrupt, so a replay repeats the session exactly.
+*/
+
+/* 8080 cycles between screen interrupts at 2MHz */
+#define MOVIE_HALF_FRAME_CYCLES ((2000000ull * VIDEO_FRAME_NS) / 2000000000ull)
+
+typedef enum {
+    MOVIE_OFF,
+    MOVIE_RECORD,
+    MOVIE_REPLAY,
+} movie_mode_t;
+
+/* Replay when the second multiboot module is a movie, record with the
+   "record" option. 'ports' are the input port bytes of 'state'.
+*/
+movie_mode_t movie_init (multiboot_info_t* mbi, i8080_state_t* state, uint8_t* ports);
+
+/* called before each end of screen interrupt, false when the replay is over */
+bool movie_frame (void);
+
+/* print the recording over COM1, or the result of the replay */
+void movie_report (void);
+
+#endif /* __MOVIE_H__ */
@@ -0,0 +1,88 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+
+#include "pci.h"
+
+/* PCI configuration mechanism #1 */
+#define PCI_CONFIG_ADDRESS 0xcf8
+#define PCI_CONFIG_DATA    0xcfc
+
+static inline uint32_t pci_config_address (const pci_device_t* pdev, const uint8_t offset)
+{
+    return ((1u << 31) |
+            ((uint32_t)pdev->bus << 16) |
+            ((uint32_t)(pdev->dev & 0x1f) << 11) |
+            ((uint32_t)(pdev->fn & 0x7) << 8) |
+            (offset & 0xfc));
+}
+
+uint32_t pci_config_read32 (const pci_device_t* pdev, const uint8_t offset)
+{
+    outport32 (PCI_CONFIG_ADDRESS, pci_config_address (pdev, offset));
+    return inport32 (PCI_CONFIG_DATA);
+}
+
+void pci_config_write32 (const pci_device_t* pdev, const uint8_t offset, const uint32_t val)
+{
+    outport32 (PCI_CONFIG_ADDRESS, pci_config_address (pdev, offset));
+    outport32 (PCI_CONFIG_DATA, val);
+}
+
+/* Brute force scan of all buses for a vendor/device id pair, functions other
+   than 0 are only probed on multi-function devices.
+*/
+bool pci_find_device (const uint16_t vendor, const uint16_t device, pci_device_t* pdev)
+{
+    const uint32_t id = ((uint32_t)device << 16) | vendor;
+
+    for (unsigned bus = 0; bus < 256; ++bus) {
+        for (unsigned dev = 0; dev < 32; ++dev) {
+            for (unsigned fn = 0; fn < 8; ++fn) {
+                pci_device_t p = {.bus = bus, .dev = dev, .fn = fn};
+                uint32_t val = pci_config_read32 (&p, PCI_VENDOR_ID);
+
+                if ((val & 0xffff) == 0xffff) {
+                    if (fn == 0) {
+                        break; /* no device */
+                    }
+                    continue;
+                }
+                if (val == id) {
+                    *pdev = p;
+                    return true;
+                }
+                if (fn == 0) {
+                    uint32_t header = pci_config_read32 (&p, PCI_HEADER_TYPE & 0xfc);
+                    if ((header & (0x80 << 16)) == 0) {
+                        break; /* single function device */
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,45 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __PCI_H__
+#define __PCI_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PCI_VENDOR_ID      0x00 /* 16 bits */
+#define PCI_DEVICE_ID      0x02 /* 16 bits */
+#define PCI_CLASS_REVISION 0x08 /* 32 bits */
+#define PCI_HEADER_TYPE    0x0e /*  8 bits */
+#define PCI_BAR0           0x10 /* 32 bits */
+
+typedef struct pci_device {
+    uint8_t bus;
+    uint8_t dev;
+    uint8_t fn;
+} pci_device_t;
+
+uint32_t pci_config_read32 (const pci_device_t* pdev, const uint8_t offset);
+void pci_config_write32 (const pci_device_t* pdev, const uint8_t offset, const uint32_t val);
+bool pci_find_device (const uint16_t vendor, const uint16_t device, pci_device_t* pdev);
+
+#endif /* __PCI_H__ */
@@ -0,0 +1,266 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "multiboot.h"
+#include "x86.h"
+#include "stdio.h"
+
+#include "pmm.h"
+
+/* pages of the 4GiB physical address space, one bit each, set if in use */
+#define PMM_PAGES (1ul << (32 - PAGE_SHIFT))
+#define PMM_FIRST_PAGE (0x100000 >> PAGE_SHIFT) /* 1MiB, below is left alone */
+
+static uint32_t bitmap[PMM_PAGES / 32];
+static size_t free_pages;
+static size_t first_free; /* no free page below this */
+static const multiboot_info_t* boot_mbi;
+
+/* link.ld */
+extern char __kernel_start__[];
+extern char __bss_end__[];
+
+static inline bool pmm_page_used (const size_t page)
+{
+    return (bitmap[page / 32] >> (page % 32)) & 1;
+}
+
+/* there is no libgcc for __builtin_popcount */
+static inline uint32_t popcount32 (uint32_t v)
+{
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return (((v + (v >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+/* mark pages first ... first+count-1 used or free, whole words at a time */
+static void pmm_mark (size_t first, size_t count, const bool used)
+{
+    while (count) {
+        const uint32_t word = (uint32_t)(first / 32);
+        const uint32_t bit = (uint32_t)(first % 32);
+        const uint32_t n = ((32 - bit) < count) ? (32 - bit) : (uint32_t)count;
+        const uint32_t mask = (n == 32) ? ~0u : (((1u << n) - 1) << bit);
+
+        if (used) {
+            free_pages -= popcount32 (~bitmap[word] & mask);
+            bitmap[word] |= mask;
+        } else {
+            free_pages += popcount32 (bitmap[word] & mask);
+            bitmap[word] &= ~mask;
+        }
+        first += n;
+        count -= n;
+    }
+}
+
+/* mark the bytes start ... end-1 used or free, partial pages are used */
+static void pmm_mark_range (uint64_t start, uint64_t end, const bool used)
+{
+    if (used) {
+        start &= ~(uint64_t)(PAGE_SIZE - 1);
+        end = (end + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+    } else {
+        start = (start + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+        end &= ~(uint64_t)(PAGE_SIZE - 1);
+    }
+
+    uint64_t first = start >> PAGE_SHIFT;
+    uint64_t last = end >> PAGE_SHIFT;
+    first = (first < PMM_FIRST_PAGE) ? PMM_FIRST_PAGE : first;
+    last = (last > PMM_PAGES) ? PMM_PAGES : last;
+    if (first < last) {
+        pmm_mark ((size_t)first, (size_t)(last - first), used);
+    }
+}
+
+typedef void (*pmm_range_fn_t) (const uint64_t start, const uint64_t end, void* ctx);
+
+/* call 'fn' for each range holding the multiboot structures, the modules
+   or the frame buffer
+*/
+static void pmm_boot_ranges (const multiboot_info_t *mbi, pmm_range_fn_t fn, void* ctx)
+{
+    fn ((uintptr_t)mbi, (uintptr_t)mbi + sizeof(*mbi), ctx);
+    if (mbi->flags & MULTIBOOT_INFO_CMDLINE) {
+        const char* cmdline = pointer_cast(const char*,mbi->cmdline);
+        size_t len = 0;
+        while (cmdline[len]) {
+            len++;
+        }
+        fn (mbi->cmdline, mbi->cmdline + len + 1, ctx);
+    }
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+        fn (mbi->mmap_addr, mbi->mmap_addr + mbi->mmap_length, ctx);
+    }
+    if (mbi->flags & MULTIBOOT_INFO_MODS) {
+        const multiboot_module_t* mod = pointer_cast(multiboot_module_t*,mbi->mods_addr);
+        fn (mbi->mods_addr, mbi->mods_addr + (mbi->mods_count * sizeof(*mod)), ctx);
+        for (unsigned i = 0; i < mbi->mods_count; ++i) {
+            fn (mod[i].mod_start, mod[i].mod_end, ctx);
+        }
+    }
+    if (mbi->flags & MULTIBOOT_INFO_FRAMEBUFFER_INFO) {
+        /* two pages when page flipping */
+        const uint64_t fb_size = (uint64_t)mbi->framebuffer_pitch * mbi->framebuffer_height;
+        fn (mbi->framebuffer_addr, mbi->framebuffer_addr + 2 * fb_size, ctx);
+    }
+}
+
+static void pmm_mark_used (const uint64_t start, const uint64_t end, void* ctx)
+{
+    (void)ctx;
+    pmm_mark_range (start, end, true);
+}
+
+void pmm_init (multiboot_info_t *mbi)
+{
+    boot_mbi = mbi;
+
+    for (size_t i = 0; i < (sizeof(bitmap)/sizeof(bitmap[0])); ++i) {
+        bitmap[i] = ~0u;
+    }
+    free_pages = 0;
+
+    /* free memory */
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+        uintptr_t p = mbi->mmap_addr;
+        while (p < (uintptr_t)mbi->mmap_addr + mbi->mmap_length) {
+            const multiboot_memory_map_t* e = pointer_cast(multiboot_memory_map_t*,p);
+            if (e->type == MULTIBOOT_MEMORY_AVAILABLE) {
+                pmm_mark_range (e->addr, e->addr + e->len, false);
+            }
+            p += e->size + sizeof(e->size);
+        }
+    } else if (mbi->flags & MULTIBOOT_INFO_MEMORY) {
+        pmm_mark_range (0x100000, 0x100000 + ((uint64_t)mbi->mem_upper * 1024), false);
+    }
+
+    /* less what is already in use */
+    pmm_mark_range ((uintptr_t)__kernel_start__, (uintptr_t)__bss_end__, true);
+    pmm_boot_ranges (mbi, pmm_mark_used, NULL);
+
+    first_free = PMM_FIRST_PAGE;
+
+    printf ("Memory: %u MiB free\n", (unsigned)(free_pages >> (20 - PAGE_SHIFT)));
+}
+
+void* pmm_alloc_pages (const size_t nr_pages)
+{
+    size_t start = 0;
+    size_t run = 0;
+    bool seen_free = false;
+
+    if (nr_pages == 0 || nr_pages > free_pages) {
+        return NULL;
+    }
+
+    /* first fit, skipping whole words of used pages */
+    for (size_t page = first_free; page < PMM_PAGES; ) {
+        if ((page % 32) == 0 && bitmap[page / 32] == ~0u) {
+            run = 0;
+            page += 32;
+            continue;
+        }
+        if (pmm_page_used (page)) {
+            run = 0;
+            page++;
+            continue;
+        }
+        if (!seen_free) {
+            seen_free = true;
+            first_free = page;
+        }
+        if (run == 0) {
+            start = page;
+        }
+        if (++run == nr_pages) {
+            pmm_mark (start, nr_pages, true);
+            return pointer_cast(void*,(uintptr_t)start << PAGE_SHIFT);
+        }
+        page++;
+    }
+
+    return NULL;
+}
+
+void pmm_free_pages (void* addr, const size_t nr_pages)
+{
+    const size_t page = (uintptr_t)addr >> PAGE_SHIFT;
+
+    pmm_mark (page, nr_pages, false);
+    if (page < first_free) {
+        first_free = page;
+    }
+}
+
+size_t pmm_free_bytes (void)
+{
+    return free_pages << PAGE_SHIFT;
+}
+
+typedef struct pmm_overlap {
+    uint64_t start;
+    uint64_t end;
+    bool overlap;
+} pmm_overlap_t;
+
+static void pmm_check_overlap (const uint64_t start, const uint64_t end, void* ctx)
+{
+    pmm_overlap_t* o = ctx;
+
+    if (start < o->end && end > o->start) {
+        o->overlap = true;
+    }
+}
+
+bool pmm_low_page_usable (const uintptr_t addr)
+{
+    const multiboot_info_t* mbi = boot_mbi;
+    pmm_overlap_t o = {.start = addr, .end = (uint64_t)addr + PAGE_SIZE, .overlap = false};
+    bool available = false;
+
+    if (mbi == NULL || o.end > (PMM_FIRST_PAGE << PAGE_SHIFT)) {
+        return false;
+    }
+
+    if (mbi->flags & MULTIBOOT_INFO_MEM_MAP) {
+        uintptr_t p = mbi->mmap_addr;
+        while (p < (uintptr_t)mbi->mmap_addr + mbi->mmap_length) {
+            const multiboot_memory_map_t* e = pointer_cast(multiboot_memory_map_t*,p);
+            if (e->type == MULTIBOOT_MEMORY_AVAILABLE && e->addr <= o.start && (e->addr + e->len) >= o.end) {
+                available = true;
+            }
+            p += e->size + sizeof(e->size);
+        }
+    } else if (mbi->flags & MULTIBOOT_INFO_MEMORY) {
+        available = o.start >= PAGE_SIZE && o.end <= ((uint64_t)mbi->mem_lower * 1024);
+    }
+
+    pmm_boot_ranges (mbi, pmm_check_overlap, &o);
+
+    return available && !o.overlap;
+}
@@ -0,0 +1,52 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __PMM_H__
+#define __PMM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "multiboot.h"
+
+#define PAGE_SIZE  4096
+#define PAGE_SHIFT 12
+
+/* Build the map of free physical pages from the multiboot memory map. Only
+   memory from 1MiB to 4GiB is used, less the kernel, the multiboot
+   structures and modules and the frame buffer.
+*/
+void pmm_init (multiboot_info_t *mbi);
+
+/* 'nr_pages' contiguous pages, or NULL */
+void* pmm_alloc_pages (const size_t nr_pages);
+void pmm_free_pages (void* addr, const size_t nr_pages);
+
+size_t pmm_free_bytes (void);
+
+/* Memory below 1MiB is not managed. True if the page at 'addr' there is
+   available RAM holding none of the multiboot structures or modules.
+*/
+bool pmm_low_page_usable (const uintptr_t addr);
+
+#endif /* __PMM_H__ */
@@ -0,0 +1,214 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+
+#include "pmu.h"
+
+#define MSR_PMC0              0x0c1
+#define MSR_PERFEVTSEL0       0x186
+#define MSR_FIXED_CTR_CTRL    0x38d
+#define MSR_PERF_GLOBAL_CTRL  0x38f
+
+#define PERFEVTSEL_USR (1 << 16)
+#define PERFEVTSEL_OS  (1 << 17)
+#define PERFEVTSEL_EN  (1 << 22)
+
+/* architectural events, event select | unit mask << 8 */
+#define EVENT_LLC_MISSES    0x412e
+#define EVENT_BRANCH_MISSES 0x00c5
+
+/* CPUID.0AH:EBX, set if the event is not available */
+#define CPUIDA_EBX_NO_LLC_MISSES    (1 << 4)
+#define CPUIDA_EBX_NO_BRANCH_MISSES (1 << 6)
+
+/* fixed counter 0 counts instructions retired, 1 unhalted core cycles */
+#define FIXED_INSTRUCTIONS 0
+#define FIXED_CYCLES       1
+#define RDPMC_FIXED        (1 << 30)
+
+/* general purpose counter used for each event, -1 if none */
+static int branch_pmc = -1;
+static int llc_pmc = -1;
+
+static bool fixed_counters;
+static uint64_t gp_mask;    /* counter widths */
+static uint64_t fixed_mask;
+static int version;
+
+/* totals since the first frame */
+static pmu_counts_t last_frame;
+static pmu_counts_t frame_sum;
+static pmu_counts_t render_sum;
+static unsigned frames;
+
+void pmu_cpu_init (void)
+{
+    uint64_t global = 0;
+
+    if (version == 0) {
+        return;
+    }
+
+    if (branch_pmc >= 0) {
+        wrmsr (MSR_PMC0 + branch_pmc, 0);
+        wrmsr (MSR_PERFEVTSEL0 + branch_pmc,
+               EVENT_BRANCH_MISSES | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_EN);
+        global |= 1ull << branch_pmc;
+    }
+    if (llc_pmc >= 0) {
+        wrmsr (MSR_PMC0 + llc_pmc, 0);
+        wrmsr (MSR_PERFEVTSEL0 + llc_pmc,
+               EVENT_LLC_MISSES | PERFEVTSEL_USR | PERFEVTSEL_OS | PERFEVTSEL_EN);
+        global |= 1ull << llc_pmc;
+    }
+    if (fixed_counters) {
+        /* count in all rings */
+        wrmsr (MSR_FIXED_CTR_CTRL, (0x3 << (FIXED_INSTRUCTIONS * 4)) | (0x3 << (FIXED_CYCLES * 4)));
+        global |= (1ull << (32 + FIXED_INSTRUCTIONS)) | (1ull << (32 + FIXED_CYCLES));
+    }
+    /* version 1 has no global control, the enable bits are enough */
+    if (version >= 2) {
+        wrmsr (MSR_PERF_GLOBAL_CTRL, global);
+    }
+}
+
+bool pmu_init (void)
+{
+    version = 0;
+
+    if (cpuid (0).eax < 0x0a) {
+        printf ("PMU: none, counting TSC ticks only\n");
+        return false;
+    }
+
+    const cpuid_t leaf = cpuid (0x0a);
+    const int nr_gp = (leaf.eax >> 8) & 0xff;
+    const int gp_width = (leaf.eax >> 16) & 0xff;
+    const int nr_fixed = leaf.edx & 0x1f;
+    const int fixed_width = (leaf.edx >> 5) & 0xff;
+
+    version = leaf.eax & 0xff;
+    if (version == 0 || nr_gp == 0) {
+        version = 0;
+        printf ("PMU: none, counting TSC ticks only\n");
+        return false;
+    }
+
+    int next = 0;
+    if (!(leaf.ebx & CPUIDA_EBX_NO_BRANCH_MISSES) && next < nr_gp) {
+        branch_pmc = next++;
+    }
+    if (!(leaf.ebx & CPUIDA_EBX_NO_LLC_MISSES) && next < nr_gp) {
+        llc_pmc = next++;
+    }
+    gp_mask = (gp_width < 64) ? ((1ull << gp_width) - 1) : ~0ull;
+
+    fixed_counters = (version >= 2) && (nr_fixed > FIXED_CYCLES);
+    fixed_mask = (fixed_width < 64) ? ((1ull << fixed_width) - 1) : ~0ull;
+
+    printf ("PMU: version %u, %u x %u-bit counters, %u x %u-bit fixed counters\n",
+            version, nr_gp, gp_width, nr_fixed, fixed_width);
+
+    pmu_cpu_init ();
+    return true;
+}
+
+void pmu_read (pmu_counts_t* counts)
+{
+    if (fixed_counters) {
+        counts->cycles = rdpmc (RDPMC_FIXED | FIXED_CYCLES);
+        counts->instructions = rdpmc (RDPMC_FIXED | FIXED_INSTRUCTIONS);
+    } else {
+        counts->cycles = rdtsc ();
+        counts->instructions = 0;
+    }
+    counts->branch_misses = (branch_pmc >= 0) ? rdpmc (branch_pmc) : 0;
+    counts->llc_misses = (llc_pmc >= 0) ? rdpmc (llc_pmc) : 0;
+}
+
+/* sum += end - start, allowing for the counters wrapping */
+static void pmu_accumulate (pmu_counts_t* sum, const pmu_counts_t* start, const pmu_counts_t* end)
+{
+    const uint64_t cycles_mask = fixed_counters ? fixed_mask : ~0ull;
+
+    sum->cycles += (end->cycles - start->cycles) & cycles_mask;
+    sum->instructions += (end->instructions - start->instructions) & fixed_mask;
+    sum->branch_misses += (end->branch_misses - start->branch_misses) & gp_mask;
+    sum->llc_misses += (end->llc_misses - start->llc_misses) & gp_mask;
+}
+
+void pmu_frame (void)
+{
+    pmu_counts_t now;
+
+    pmu_read (&now);
+    if (last_frame.cycles != 0) {
+        pmu_accumulate (&frame_sum, &last_frame, &now);
+        frames++;
+    }
+    last_frame = now;
+}
+
+void pmu_render (const pmu_counts_t* start)
+{
+    pmu_counts_t now;
+
+    pmu_read (&now);
+    pmu_accumulate (&render_sum, start, &now);
+}
+
+static void pmu_print (const char* name, const pmu_counts_t* sum)
+{
+    const uint64_t cycles = sum->cycles / frames;
+    const uint64_t instructions = sum->instructions / frames;
+
+    if (!fixed_counters) {
+        printf ("  %s: %u TSC ticks/frame\n", name, (unsigned)cycles);
+        return;
+    }
+
+    /* IPC and branch misses per 1000 instructions to 2 decimal places */
+    const unsigned ipc = cycles ? (unsigned)((instructions * 100) / cycles) : 0;
+    const unsigned mpki = sum->instructions ? (unsigned)((sum->branch_misses * 100000) / sum->instructions) : 0;
+
+    printf ("  %s: %u cycles/frame, %u instructions, IPC %u.%02u\n",
+            name, (unsigned)cycles, (unsigned)instructions, ipc / 100, ipc % 100);
+    printf ("  %s: %u branch misses/frame (%u.%02u per 1000 instructions), %u LLC misses/frame\n",
+            name, (unsigned)(sum->branch_misses / frames), mpki / 100, mpki % 100,
+            (unsigned)(sum->llc_misses / frames));
+}
+
+void pmu_report (void)
+{
+    if (frames == 0) {
+        return;
+    }
+
+    printf ("pmu: %u frames%s\n", frames, version ? "" : " (TSC only)");
+    pmu_print ("frame ", &frame_sum);
+    pmu_print ("render", &render_sum);
+}
@@ -0,0 +1,61 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __PMU_H__
+#define __PMU_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Counts read from the architectural performance monitoring unit. Counts
+   the PMU does not provide are zero, except cycles which falls back to TSC
+   ticks.
+*/
+typedef struct pmu_counts {
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t branch_misses;
+    uint64_t llc_misses;
+} pmu_counts_t;
+
+/* Find the PMU (CPUID leaf 0xA) and start the counters on this CPU, returns
+   false if only the TSC is available.
+*/
+bool pmu_init (void);
+
+/* start the counters found by pmu_init on another CPU */
+void pmu_cpu_init (void);
+
+void pmu_read (pmu_counts_t* counts);
+
+/* end of a video frame on the emulator CPU, the frame counts include the
+   rendering unless it is done by the render core
+*/
+void pmu_frame (void);
+
+/* end of rendering on the render CPU, 'start' was read before it began */
+void pmu_render (const pmu_counts_t* start);
+
+/* print the average counts per frame */
+void pmu_report (void);
+
+#endif /* __PMU_H__ */
@@ -0,0 +1,129 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "arena.h"
+
+#include "profile.h"
+
+/* CMOS real time clock */
+#define RTC_INDEX 0x70
+#define RTC_DATA  0x71
+#define RTC_NMI_DISABLE 0x80
+#define RTC_REG_A 0x0a /* rate select in bits 3...0 */
+#define RTC_REG_B 0x0b
+#define RTC_REG_C 0x0c /* interrupt flags, read to acknowledge */
+#define RTC_REG_B_PIE 0x40 /* periodic interrupt enable */
+
+/* each bucket counts the samples in 2^PROFILE_SHIFT bytes of .text */
+#define PROFILE_SHIFT   4
+
+/* link.ld */
+extern char __text_start__[];
+extern char __text_end__[];
+
+/* one per 2^PROFILE_SHIFT bytes of .text */
+static arena_t buckets_arena;
+static uint32_t* buckets;
+static unsigned nr_buckets;
+static unsigned samples;
+static unsigned outside;
+static int sample_hz;
+
+static uint8_t rtc_read (const uint8_t reg)
+{
+    outport8 (RTC_INDEX, RTC_NMI_DISABLE | reg);
+    return inport8 (RTC_DATA);
+}
+
+static void rtc_write (const uint8_t reg, const uint8_t val)
+{
+    outport8 (RTC_INDEX, RTC_NMI_DISABLE | reg);
+    outport8 (RTC_DATA, val);
+}
+
+/* IRQ 8, 'ip' is the address the interrupt returns to */
+void profile_sample (const uintptr_t ip)
+{
+    const uintptr_t off = ip - (uintptr_t)__text_start__;
+
+    rtc_read (RTC_REG_C);
+
+    samples++;
+    if (ip >= (uintptr_t)__text_start__ && ip < (uintptr_t)__text_end__ &&
+        (off >> PROFILE_SHIFT) < nr_buckets) {
+        buckets[off >> PROFILE_SHIFT]++;
+    } else {
+        outside++;
+    }
+}
+
+void profile_init (const int hz)
+{
+    nr_buckets = (unsigned)(((uintptr_t)__text_end__ - (uintptr_t)__text_start__) >> PROFILE_SHIFT) + 1;
+    if (!arena_init (&buckets_arena, "profile", nr_buckets * sizeof(uint32_t))) {
+        printf ("Profiling disabled\n");
+        return;
+    }
+    buckets = arena_alloc (&buckets_arena, nr_buckets * sizeof(uint32_t), sizeof(uint32_t));
+
+    /* the periodic rate is 32768 >> (rate - 1) Hz, rate 3 (8192Hz) ... 15 (2Hz) */
+    int rate = 15;
+    while (rate > 3 && (32768 >> (rate - 2)) <= hz) {
+        rate--;
+    }
+    sample_hz = 32768 >> (rate - 1);
+
+    const unsigned long flags = irq_save ();
+    rtc_write (RTC_REG_A, (rtc_read (RTC_REG_A) & 0xf0) | rate);
+    rtc_write (RTC_REG_B, rtc_read (RTC_REG_B) | RTC_REG_B_PIE);
+    rtc_read (RTC_REG_C);
+    outport8 (RTC_INDEX, 0); /* NMIs back on */
+    irq_restore (flags);
+
+    printf ("Profiling at %uHz, .text 0x%08x ... 0x%08x\n", sample_hz,
+            (unsigned long)__text_start__, (unsigned long)__text_end__);
+}
+
+void profile_report (void)
+{
+    if (sample_hz == 0) {
+        return;
+    }
+
+    /* stop sampling */
+    rtc_write (RTC_REG_B, rtc_read (RTC_REG_B) & ~RTC_REG_B_PIE);
+    outport8 (RTC_INDEX, 0);
+
+    printf ("profile: %u samples at %uHz, %u outside .text\n", samples, sample_hz, outside);
+    for (unsigned i = 0; i < nr_buckets; ++i) {
+        if (buckets[i]) {
+            printf ("profile: %08x %u\n",
+                    (unsigned long)__text_start__ + (i << PROFILE_SHIFT), buckets[i]);
+        }
+    }
+    printf ("profile: end\n");
+}
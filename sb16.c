@@ -0,0 +1,190 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "timebase.h"
+
+#include "sb16.h"
+
+/* DSP */
+#define SB16_BASE   0x220
+#define DSP_MIXER_INDEX (SB16_BASE + 0x4)
+#define DSP_MIXER_DATA  (SB16_BASE + 0x5)
+#define DSP_RESET   (SB16_BASE + 0x6)
+#define DSP_READ    (SB16_BASE + 0xa)
+#define DSP_WRITE   (SB16_BASE + 0xc) /* bit 7 set when busy */
+#define DSP_STATUS  (SB16_BASE + 0xe) /* bit 7 set when data to read */
+#define DSP_ACK16   (SB16_BASE + 0xf) /* read to acknowledge a 16-bit interrupt */
+
+#define DSP_READY         0xaa
+#define DSP_SET_RATE      0x41
+#define DSP_OUT16_AUTO    0xb6 /* 16-bit output, auto-init, FIFO on */
+#define DSP_MODE_MONO_S16 0x10
+#define DSP_SPEAKER_ON    0xd1
+#define DSP_PAUSE16       0xd5
+#define DSP_EXIT_AUTO16   0xd9
+#define DSP_VERSION       0xe1
+
+#define MIXER_IRQ 0x80
+#define MIXER_DMA 0x81
+#define MIXER_IRQ_5 0x02
+#define MIXER_DMA_1_5 0x22 /* 8-bit channel 1, 16-bit channel 5 */
+
+/* second DMA controller, channel 5 is its channel 1 */
+#define DMA16_MASK      0xd4
+#define DMA16_MODE      0xd6
+#define DMA16_FLIPFLOP  0xd8
+#define DMA5_ADDR       0xc4 /* in words */
+#define DMA5_COUNT      0xc6 /* in words, less one */
+#define DMA5_PAGE       0x8b
+#define DMA_CH1         0x01
+#define DMA_MASK_ON     0x04
+#define DMA_MODE_PLAY   0x58 /* single, auto-init, memory to device */
+
+#define DSP_TIMEOUT_US 1000
+
+/* two blocks, aligned so they neither cross a 128KB DMA boundary nor the
+   16MB ISA limit as long as the kernel is below it
+*/
+static int16_t dma_buf[2 * SB16_BLOCK] __attribute__((aligned(2 * SB16_BLOCK * sizeof(int16_t))));
+
+static sb16_fill_fn_t fill_fn;
+static int next_block;
+static bool playing;
+
+static bool dsp_write (const uint8_t val)
+{
+    for (unsigned us = 0; us < DSP_TIMEOUT_US; ++us) {
+        if (!(inport8 (DSP_WRITE) & 0x80)) {
+            outport8 (DSP_WRITE, val);
+            return true;
+        }
+        timebase_delay_us (1);
+    }
+    return false;
+}
+
+static int dsp_read (void)
+{
+    for (unsigned us = 0; us < DSP_TIMEOUT_US; ++us) {
+        if (inport8 (DSP_STATUS) & 0x80) {
+            return inport8 (DSP_READ);
+        }
+        timebase_delay_us (1);
+    }
+    return -1;
+}
+
+static bool dsp_reset (void)
+{
+    outport8 (DSP_RESET, 1);
+    timebase_delay_us (3);
+    outport8 (DSP_RESET, 0);
+
+    return dsp_read () == DSP_READY;
+}
+
+static void mixer_write (const uint8_t reg, const uint8_t val)
+{
+    outport8 (DSP_MIXER_INDEX, reg);
+    outport8 (DSP_MIXER_DATA, val);
+}
+
+static void dma_start (void)
+{
+    const uintptr_t phys = (uintptr_t)dma_buf;
+    const uint32_t words = sizeof(dma_buf) / 2;
+
+    outport8 (DMA16_MASK, DMA_MASK_ON | DMA_CH1);
+    outport8 (DMA16_FLIPFLOP, 0);
+    outport8 (DMA16_MODE, DMA_MODE_PLAY | DMA_CH1);
+    outport8 (DMA5_ADDR, (uint8_t)((phys >> 1) & 0xff));
+    outport8 (DMA5_ADDR, (uint8_t)((phys >> 9) & 0xff));
+    outport8 (DMA5_COUNT, (uint8_t)((words - 1) & 0xff));
+    outport8 (DMA5_COUNT, (uint8_t)(((words - 1) >> 8) & 0xff));
+    outport8 (DMA5_PAGE, (uint8_t)((phys >> 16) & 0xff));
+    outport8 (DMA16_MASK, DMA_CH1);
+}
+
+bool sb16_init (const unsigned rate, sb16_fill_fn_t fill)
+{
+    if ((uintptr_t)dma_buf >= 0x1000000 || !dsp_reset () || !dsp_write (DSP_VERSION)) {
+        return false;
+    }
+    const int major = dsp_read ();
+    const int minor = dsp_read ();
+    if (major < 4) {
+        return false;
+    }
+
+    /* QEMU's defaults, set in case the card was configured otherwise */
+    mixer_write (MIXER_IRQ, MIXER_IRQ_5);
+    mixer_write (MIXER_DMA, MIXER_DMA_1_5);
+
+    fill_fn = fill;
+    fill_fn (&dma_buf[0], SB16_BLOCK);
+    fill_fn (&dma_buf[SB16_BLOCK], SB16_BLOCK);
+    next_block = 0;
+    dma_start ();
+
+    dsp_write (DSP_SPEAKER_ON);
+    dsp_write (DSP_SET_RATE);
+    dsp_write ((uint8_t)((rate >> 8) & 0xff));
+    dsp_write ((uint8_t)(rate & 0xff));
+    dsp_write (DSP_OUT16_AUTO);
+    dsp_write (DSP_MODE_MONO_S16);
+    dsp_write ((uint8_t)((SB16_BLOCK - 1) & 0xff));
+    dsp_write ((uint8_t)(((SB16_BLOCK - 1) >> 8) & 0xff));
+    playing = true;
+
+    printf ("SB16: DSP %u.%02u, %uHz, DMA buffer 0x%08x\n",
+            major, minor, rate, (unsigned long)dma_buf);
+
+    return true;
+}
+
+/* IRQ 5, the block the DSP just finished is refilled while it plays the
+   other one
+*/
+void sb16_irq_handler (void)
+{
+    inport8 (DSP_ACK16);
+
+    if (playing) {
+        fill_fn (&dma_buf[next_block * SB16_BLOCK], SB16_BLOCK);
+        next_block ^= 1;
+    }
+}
+
+void sb16_stop (void)
+{
+    if (playing) {
+        playing = false;
+        dsp_write (DSP_PAUSE16);
+        dsp_write (DSP_EXIT_AUTO16);
+        outport8 (DMA16_MASK, DMA_MASK_ON | DMA_CH1);
+    }
+}
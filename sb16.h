@@ -0,0 +1,41 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __SB16_H__
+#define __SB16_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Sound Blaster 16 at 0x220, IRQ 5, 16-bit DMA channel 5, playing 16-bit
+   mono from a two block auto-init DMA buffer.
+*/
+#define SB16_BLOCK 256 /* samples per block, an interrupt per block */
+
+/* fill 'nr_samples' of 'buf', called from the interrupt */
+typedef void (*sb16_fill_fn_t) (int16_t* buf, const unsigned nr_samples);
+
+/* start playing at 'rate', false if there is no SB16 */
+bool sb16_init (const unsigned rate, sb16_fill_fn_t fill);
+void sb16_stop (void);
+
+#endif /* __SB16_H__ */
@@ -0,0 +1,126 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "stdio.h"
+#include "smp.h"
+#include "acpi.h"
+#include "apic.h"
+#include "timebase.h"
+#include "pmm.h"
+
+#define AP_STARTUP_PAGE (AP_TRAMPOLINE_ADDR >> 12)
+#define AP_START_TIMEOUT_US 100000 /* 100ms */
+
+/* ap_boot.S */
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_end[];
+extern uintptr_t ap_stack_top;
+
+static uint8_t ap_ids[ACPI_MAX_CPUS];
+static int nr_aps;
+
+static uint8_t ap_stacks[ACPI_MAX_CPUS][AP_STACK_SIZE] __attribute__((aligned(16)));
+
+static smp_entry_fn_t ap_entry;
+static volatile bool ap_started;
+
+/* called from ap_boot.S once the AP is running on its own stack */
+void ap_main (void)
+{
+    const smp_entry_fn_t entry = ap_entry;
+    __atomic_store_n (&ap_started, true, __ATOMIC_RELEASE);
+    entry ();
+}
+
+int smp_init (void)
+{
+    uint8_t ids[ACPI_MAX_CPUS];
+    int nr_cpus;
+
+    if (!apic_init ()) {
+        return 0;
+    }
+
+    /* the trampoline is copied over this page, the multiboot data is still
+       read after the other CPUs are started
+    */
+    if (!pmm_low_page_usable (AP_TRAMPOLINE_ADDR)) {
+        printf ("smp: page 0x%x is in use, not starting other cpus\n", AP_TRAMPOLINE_ADDR);
+        return 0;
+    }
+
+    nr_cpus = acpi_find_cpus (ids);
+
+    const uint8_t bsp_id = apic_id ();
+    nr_aps = 0;
+    for (int i = 0; i < nr_cpus; ++i) {
+        if (ids[i] != bsp_id) {
+            ap_ids[nr_aps++] = ids[i];
+        }
+    }
+
+    printf ("smp: %d cpu(s), bsp apic id %d\n", nr_cpus, bsp_id);
+
+    return nr_aps;
+}
+
+bool smp_start_cpu (const int cpu, smp_entry_fn_t entry)
+{
+    if ((cpu < 0) || (cpu >= nr_aps)) {
+        return false;
+    }
+
+    const uint8_t id = ap_ids[cpu];
+
+    memcpy ((void*)AP_TRAMPOLINE_ADDR, ap_trampoline_start,
+            ap_trampoline_end - ap_trampoline_start);
+
+    ap_stack_top = (uintptr_t)&ap_stacks[cpu][AP_STACK_SIZE];
+    ap_entry = entry;
+    ap_started = false;
+
+    /* INIT-SIPI-SIPI */
+    apic_send_init (id);
+    timebase_delay_us (10000);
+    apic_send_startup (id, AP_STARTUP_PAGE);
+    timebase_delay_us (200);
+    if (!__atomic_load_n (&ap_started, __ATOMIC_ACQUIRE)) {
+        apic_send_startup (id, AP_STARTUP_PAGE);
+    }
+
+    const uint64_t deadline = now_us () + AP_START_TIMEOUT_US;
+    while (!__atomic_load_n (&ap_started, __ATOMIC_ACQUIRE)) {
+        if (now_us () > deadline) {
+            printf ("smp: cpu apic id %d did not start\n", id);
+            return false;
+        }
+        asm volatile ("pause");
+    }
+
+    printf ("smp: started cpu apic id %d\n", id);
+
+    return true;
+}
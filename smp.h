@@ -0,0 +1,46 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __SMP_H__
+#define __SMP_H__
+
+/* the other CPUs start in real mode at this address, it must be a 4KiB
+   aligned address below 1MiB
+*/
+#define AP_TRAMPOLINE_ADDR 0x8000
+
+#define AP_STACK_SIZE 0x4000 /* 16KiB */
+
+#ifndef __ASSEMBLER__
+#include <stdbool.h>
+
+typedef void (*smp_entry_fn_t) (void);
+
+/* find the other CPUs, returns how many there are */
+int smp_init (void);
+
+/* start other CPU number 'cpu' (0 ... smp_init()-1) running 'entry' */
+bool smp_start_cpu (const int cpu, smp_entry_fn_t entry);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* __SMP_H__ */
@@ -0,0 +1,243 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "timebase.h"
+#include "cmdline.h"
+#include "sb16.h"
+#include "mixer.h"
+
+#include "sound.h"
+
+/* PIT channel 2 drives the speaker when both gate bits of port 0x61 are set */
+#define PIT_CH2_DATA 0x42
+#define PIT_CMD      0x43
+#define PIT_CH2_SQUARE_WAVE 0xb6 /* channel 2, lobyte/hibyte, mode 3 */
+#define SPEAKER_PORT 0x61
+#define SPEAKER_GATE 0x03
+
+#define PORT3_MASK  0x003f
+#define PORT5_MASK  0x001f
+#define PORT5_SHIFT 6
+
+typedef struct tone {
+    uint16_t hz;    /* 0 is silence */
+    uint8_t ticks;  /* length in screen events, 1/120s */
+} tone_t;
+
+typedef struct sound {
+    const tone_t* tones;
+    uint8_t nr_tones;
+    uint8_t repeat;   /* times the tones are played, 0 while the port bit is set */
+    uint8_t priority; /* the speaker plays the highest priority sound */
+} sound_t;
+
+static const tone_t ufo_tones[] = {
+    {700, 2}, {760, 2}, {820, 2}, {760, 2}
+};
+static const tone_t shot_tones[] = {
+    {1400, 1}, {1200, 1}, {1000, 1}, {850, 1}, {700, 1}, {600, 1}, {500, 2}
+};
+static const tone_t flash_tones[] = {
+    {160, 7}, {120, 7}, {200, 7}, {90, 7}, {180, 7}, {110, 7}, {140, 7}, {80, 7},
+    {170, 7}, {100, 7}, {130, 7}, {70, 7}, {150, 7}, {90, 7}, {60, 7}, {50, 7}
+};
+static const tone_t invader_tones[] = {
+    {900, 1}, {700, 1}, {550, 1}, {400, 1}, {300, 2}, {200, 2}
+};
+static const tone_t extend_tones[] = {
+    {1000, 6}, {0, 3}, {1000, 6}, {0, 3}, {1000, 6}, {0, 3}, {1000, 12}
+};
+static const tone_t fleet1_tones[] = { {98, 5} };
+static const tone_t fleet2_tones[] = { {87, 5} };
+static const tone_t fleet3_tones[] = { {78, 5} };
+static const tone_t fleet4_tones[] = { {73, 5} };
+static const tone_t ufo_hit_tones[] = {
+    {1800, 2}, {1200, 2}, {300, 2}
+};
+
+#define SOUND(tones, repeat, priority) \
+    { tones, sizeof(tones)/sizeof(tones[0]), repeat, priority }
+
+static const sound_t sounds[SOUND_BITS] = {
+    SOUND(ufo_tones, 0, 1),      /* port 3 bit 0, UFO (repeats) */
+    SOUND(shot_tones, 1, 4),     /* port 3 bit 1, shot */
+    SOUND(flash_tones, 1, 7),    /* port 3 bit 2, flash (player die) */
+    SOUND(invader_tones, 1, 5),  /* port 3 bit 3, invader die */
+    SOUND(extend_tones, 1, 3),   /* port 3 bit 4, extended play */
+    { NULL, 0, 0, 0 },           /* port 3 bit 5, amp enable */
+    SOUND(fleet1_tones, 1, 2),   /* port 5 bit 0, fleet movement 1 */
+    SOUND(fleet2_tones, 1, 2),   /* port 5 bit 1, fleet movement 2 */
+    SOUND(fleet3_tones, 1, 2),   /* port 5 bit 2, fleet movement 3 */
+    SOUND(fleet4_tones, 1, 2),   /* port 5 bit 3, fleet movement 4 */
+    SOUND(ufo_hit_tones, 8, 6),  /* port 5 bit 4, UFO hit */
+};
+
+typedef struct voice {
+    uint8_t tone;
+    uint8_t ticks;
+    uint8_t repeat;
+} voice_t;
+
+static bool enabled;
+static bool pcm; /* SB16 rather than the speaker */
+
+/* written by the io handler */
+static uint16_t port_bits;
+static uint16_t start_req;
+
+/* owned by the timer interrupt */
+static voice_t voices[SOUND_BITS];
+static uint16_t active;
+static uint16_t speaker_hz;
+
+static void speaker_set (const uint16_t hz)
+{
+    if (hz == speaker_hz) {
+        return;
+    }
+    speaker_hz = hz;
+
+    if (hz == 0) {
+        outport8 (SPEAKER_PORT, inport8 (SPEAKER_PORT) & ~SPEAKER_GATE);
+    } else {
+        const uint32_t div = PIT_HZ / hz;
+        outport8 (PIT_CMD, PIT_CH2_SQUARE_WAVE);
+        outport8 (PIT_CH2_DATA, (uint8_t)(div & 0xff));
+        outport8 (PIT_CH2_DATA, (uint8_t)((div >> 8) & 0xff));
+        outport8 (SPEAKER_PORT, inport8 (SPEAKER_PORT) | SPEAKER_GATE);
+    }
+}
+
+/* SB16 interrupt */
+static void pcm_fill (int16_t* buf, const unsigned nr_samples)
+{
+    const uint16_t level = __atomic_load_n (&port_bits, __ATOMIC_RELAXED);
+    const uint16_t start = __atomic_exchange_n (&start_req, 0, __ATOMIC_RELAXED);
+
+    mixer_mix (buf, nr_samples, start, level);
+}
+
+void sound_init (void)
+{
+    enabled = !cmdline_has ("nosound");
+    port_bits = 0;
+    start_req = 0;
+    active = 0;
+    speaker_hz = 0;
+    outport8 (SPEAKER_PORT, inport8 (SPEAKER_PORT) & ~SPEAKER_GATE);
+
+    /* "pcspk" keeps to the speaker when there is an SB16 too */
+    pcm = false;
+    if (enabled && !cmdline_has ("pcspk")) {
+        mixer_init (SOUND_RATE);
+        pcm = sb16_init (SOUND_RATE, pcm_fill);
+    }
+}
+
+/* Only the rising edges are passed on, the 8080 writes these ports on
+   every fleet step and sound change so this is the whole cost of audio in
+   the emulation loop.
+*/
+void sound_port (const uint8_t port, const uint8_t byte)
+{
+    uint16_t bits = port_bits;
+
+    if (port == 3) {
+        bits = (uint16_t)((bits & ~PORT3_MASK) | (byte & PORT3_MASK));
+    } else {
+        bits = (uint16_t)((bits & PORT3_MASK) | ((byte & PORT5_MASK) << PORT5_SHIFT));
+    }
+
+    const uint16_t rising = bits & ~port_bits;
+    __atomic_store_n (&port_bits, bits, __ATOMIC_RELAXED);
+    if (rising) {
+        __atomic_or_fetch (&start_req, rising, __ATOMIC_RELAXED);
+    }
+}
+
+void sound_tick (void)
+{
+    if (!enabled || pcm) {
+        return;
+    }
+
+    const uint16_t level = __atomic_load_n (&port_bits, __ATOMIC_RELAXED);
+    const uint16_t start = __atomic_exchange_n (&start_req, 0, __ATOMIC_RELAXED);
+    int best = -1;
+
+    for (int i = 0; i < SOUND_BITS; ++i) {
+        const sound_t* s = &sounds[i];
+        voice_t* v = &voices[i];
+        const uint16_t bit = (uint16_t)(1u << i);
+
+        if (s->nr_tones == 0) {
+            continue;
+        }
+        if (start & bit) {
+            v->tone = 0;
+            v->ticks = s->tones[0].ticks;
+            v->repeat = s->repeat;
+            active |= bit;
+        } else if (active & bit) {
+            if (--v->ticks == 0) {
+                if (++v->tone == s->nr_tones) {
+                    v->tone = 0;
+                    if (s->repeat && --v->repeat == 0) {
+                        active &= ~bit;
+                        continue;
+                    }
+                }
+                v->ticks = s->tones[v->tone].ticks;
+            }
+        }
+        /* repeating sounds stop when the bit is cleared */
+        if (s->repeat == 0 && !(level & bit)) {
+            active &= ~bit;
+        }
+
+        if ((active & bit) && (best < 0 || s->priority > sounds[best].priority)) {
+            best = i;
+        }
+    }
+
+    if (best >= 0 && (level & SOUND_AMP_ENABLE)) {
+        speaker_set (sounds[best].tones[voices[best].tone].hz);
+    } else {
+        speaker_set (0);
+    }
+}
+
+void sound_stop (void)
+{
+    if (pcm) {
+        sb16_stop ();
+    }
+    enabled = false;
+    speaker_hz = 0;
+    outport8 (SPEAKER_PORT, inport8 (SPEAKER_PORT) & ~SPEAKER_GATE);
+}
@@ -0,0 +1,50 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __SOUND_H__
+#define __SOUND_H__
+
+#include <stdint.h>
+
+/* Space Invaders sound effects, mixed into a Sound Blaster 16's DMA buffer
+   when there is one, otherwise tones on the PC speaker. Writes to the sound
+   ports only note bit transitions, the sounds are made in interrupts.
+*/
+
+/* port 3 bits 0...5 are sound bits 0...5, port 5 bits 0...4 are 6...10 */
+#define SOUND_BITS       11
+#define SOUND_AMP_ENABLE 0x0020
+
+#define SOUND_RATE 22050
+
+void sound_init (void);
+
+/* OUT to port 3 or 5, called from the io handler */
+void sound_port (const uint8_t port, const uint8_t byte);
+
+/* called from the timer interrupt, twice a frame */
+void sound_tick (void);
+
+/* silence the speaker, interrupts disabled */
+void sound_stop (void);
+
+#endif /* __SOUND_H__ */
@@ -33,17 +33,121 @@
 
 #define PRINT_BUF_SIZE 256
 
+/* UART registers */
+#define UART_IER 1 /* interrupt enable */
+#define UART_IIR 2 /* interrupt identification (read) */
+#define UART_FCR 2 /* FIFO control (write) */
+#define UART_MCR 4 /* modem control */
+#define UART_LSR 5 /* line status */
+
+#define UART_IER_THRE   0x02
+#define UART_FCR_ENABLE 0xc7 /* enable and clear FIFOs */
+#define UART_MCR_OUT2   0x0b /* DTR, RTS and OUT2, which gates the IRQ */
+#define UART_FIFO_SIZE  16
+
+/* transmit buffer, must be a power of 2 */
+#define TX_BUF_SIZE 4096
+
 static char* lookup = "0123456789abcdef";
 
+/* Output is written straight to the UART until serial_init, then it is
+   queued in tx_buf and sent from the transmit holding register empty
+   interrupt. tx_lock is taken with interrupts disabled, printf may be called
+   from any CPU and from interrupt handlers.
+*/
+static char tx_buf[TX_BUF_SIZE];
+static unsigned tx_head;
+static unsigned tx_tail;
+static bool tx_buffered;
+static volatile int tx_lock;
+
 static int serial_tx_is_empty (void)
 {
-    return (inport8(COM1 + 5) & 0x20);
+    return (inport8(COM1 + UART_LSR) & 0x20);
+}
+
+static inline void serial_lock (void)
+{
+    while (__atomic_exchange_n (&tx_lock, 1, __ATOMIC_ACQUIRE)) {
+        asm volatile ("pause");
+    }
+}
+
+static inline void serial_unlock (void)
+{
+    __atomic_store_n (&tx_lock, 0, __ATOMIC_RELEASE);
+}
+
+/* refill the UART FIFO if it is empty, called with tx_lock held */
+static void serial_tx_fill (void)
+{
+    if (serial_tx_is_empty ()) {
+        for (int i = 0; i < UART_FIFO_SIZE && tx_tail != tx_head; ++i) {
+            outport8 (COM1, tx_buf[tx_tail++ & (TX_BUF_SIZE - 1)]);
+        }
+    }
+}
+
+void serial_init (void)
+{
+    const unsigned long flags = irq_save ();
+    serial_lock ();
+
+    outport8 (COM1 + UART_FCR, UART_FCR_ENABLE);
+    outport8 (COM1 + UART_MCR, UART_MCR_OUT2);
+    outport8 (COM1 + UART_IER, UART_IER_THRE);
+    tx_head = tx_tail = 0;
+    tx_buffered = true;
+
+    serial_unlock ();
+    irq_restore (flags);
+}
+
+/* IRQ 4, the UART is ready for more data */
+void serial_irq_handler (void)
+{
+    inport8 (COM1 + UART_IIR);
+
+    serial_lock ();
+    serial_tx_fill ();
+    serial_unlock ();
+}
+
+void serial_flush (void)
+{
+    const unsigned long flags = irq_save ();
+    serial_lock ();
+
+    while (tx_tail != tx_head) {
+        serial_tx_fill ();
+    }
+    outport8 (COM1 + UART_IER, 0);
+    tx_buffered = false;
+
+    serial_unlock ();
+    irq_restore (flags);
 }
 
 int putchar (int c)
 {
-    while(!serial_tx_is_empty());
-    outport8(COM1, c);
+    const unsigned long flags = irq_save ();
+    serial_lock ();
+
+    if (tx_buffered) {
+        /* full, wait for the UART to take some */
+        while ((tx_head - tx_tail) == TX_BUF_SIZE) {
+            serial_tx_fill ();
+        }
+        tx_buf[tx_head++ & (TX_BUF_SIZE - 1)] = (char)c;
+        /* the interrupt only follows a transmission, start one if idle */
+        serial_tx_fill ();
+    } else {
+        while(!serial_tx_is_empty());
+        outport8(COM1, c);
+    }
+
+    serial_unlock ();
+    irq_restore (flags);
     return 0;
 }
 
@@ -38,4 +38,11 @@ int vsnprintf (char *str, size_t size, const char *format, va_list ap);
 int putchar(int c);
 int puts (const char* str);
 
+/* Output goes to COM1. After serial_init it is buffered and sent from the
+   UART interrupt, serial_flush waits for the buffer to empty and returns to
+   writing directly.
+*/
+void serial_init (void);
+void serial_flush (void);
+
 #endif // __STDIO_H__
@@ -0,0 +1,212 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "x86.h"
+#include "stdio.h"
+#include "timebase.h"
+#include "timer.h"
+#include "pmu.h"
+#include "pmm.h"
+#include "arena.h"
+
+#include "telemetry.h"
+
+/* frame records kept, a power of 2 taken from free memory with a static
+   fallback */
+#define TELEMETRY_MIN_FRAMES 512
+#define TELEMETRY_MAX_FRAMES 65536
+
+/* frame interval jitter, JITTER_STEP_US wide buckets centered on zero */
+#define JITTER_BUCKETS 16
+#define JITTER_STEP_US 100
+
+/* render time, bucket n counts times of 2^(n-1) ... 2^n-1 microseconds */
+#define RENDER_BUCKETS 16
+
+/* a frame delivered more than this after the nominal interval is late */
+#define LATE_FRAME_US 1000
+
+#define REPORT_INTERVAL_NS (10 * 1000000000ull)
+
+typedef struct frame_record {
+    uint64_t rst1;          /* TSC at mid screen interrupt delivery */
+    uint64_t rst2;          /* TSC at end of screen interrupt delivery */
+    uint64_t render_start;  /* TSC at start of the first render of the frame */
+    uint64_t render_ticks;  /* TSC ticks spent rendering the frame */
+    uint32_t cycles;        /* 8080 cycles executed during the frame */
+} frame_record_t;
+
+static frame_record_t frames_static[TELEMETRY_MIN_FRAMES];
+static frame_record_t* frames = frames_static;
+static unsigned frame_mask = TELEMETRY_MIN_FRAMES - 1;
+static unsigned frame_nr;
+static arena_t frames_arena;
+
+static uint64_t last_rst2;
+static uint64_t last_cycles;
+
+/* Render time of the current frame. The renderer (timer interrupt or render
+   core) adds to these while the main loop ends frames, telemetry_rst takes
+   them with an atomic exchange. 32 bits keeps that a single instruction on
+   i386, a frame is far shorter than 2^32 TSC ticks.
+*/
+static uint32_t render_ticks;
+static uint32_t render_start; /* low 32 bits of the TSC | 1, 0 before the first render */
+
+static unsigned jitter_hist[JITTER_BUCKETS];
+static unsigned render_hist[RENDER_BUCKETS];
+static unsigned late_frames;
+static int64_t jitter_min_us;
+static int64_t jitter_max_us;
+
+static uint64_t next_report_ns;
+
+void telemetry_init (void)
+{
+    unsigned nr = TELEMETRY_MAX_FRAMES;
+
+    /* no more than 1/16th of free memory */
+    while (nr > TELEMETRY_MIN_FRAMES &&
+           (nr * sizeof(frame_record_t)) > (pmm_free_bytes () / 16)) {
+        nr >>= 1;
+    }
+    if (nr > TELEMETRY_MIN_FRAMES &&
+        arena_init (&frames_arena, "telemetry", nr * sizeof(frame_record_t))) {
+        frames = arena_alloc (&frames_arena, nr * sizeof(frame_record_t), 8);
+        frame_mask = nr - 1;
+    } else {
+        memset (frames_static, 0, sizeof(frames_static));
+    }
+    memset (jitter_hist, 0, sizeof(jitter_hist));
+    memset (render_hist, 0, sizeof(render_hist));
+    frame_nr = 0;
+    last_rst2 = 0;
+    __atomic_store_n (&render_ticks, 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&render_start, 0, __ATOMIC_RELAXED);
+    late_frames = 0;
+    jitter_min_us = 0;
+    jitter_max_us = 0;
+    next_report_ns = now_ns () + REPORT_INTERVAL_NS;
+}
+
+static inline frame_record_t* current_frame (void)
+{
+    return &frames[frame_nr & frame_mask];
+}
+
+static void telemetry_end_frame (frame_record_t* f)
+{
+    /* render time */
+    unsigned us = (unsigned)(timebase_ticks_to_ns (f->render_ticks) / 1000);
+    int bucket = 0;
+    while (us && bucket < (RENDER_BUCKETS - 1)) {
+        us >>= 1;
+        bucket++;
+    }
+    render_hist[bucket]++;
+
+    /* interval since the previous frame compared with the video rate */
+    if (last_rst2 != 0) {
+        const int64_t interval_ns = (int64_t)timebase_ticks_to_ns (f->rst2 - last_rst2);
+        const int64_t jitter_us = (interval_ns - (int64_t)VIDEO_FRAME_NS) / 1000;
+        int64_t b = (jitter_us + (JITTER_BUCKETS/2) * JITTER_STEP_US) / JITTER_STEP_US;
+
+        b = (b < 0) ? 0 : ((b >= JITTER_BUCKETS) ? (JITTER_BUCKETS - 1) : b);
+        jitter_hist[b]++;
+
+        jitter_min_us = (jitter_us < jitter_min_us) ? jitter_us : jitter_min_us;
+        jitter_max_us = (jitter_us > jitter_max_us) ? jitter_us : jitter_max_us;
+        if (jitter_us > LATE_FRAME_US) {
+            late_frames++;
+        }
+    }
+    last_rst2 = f->rst2;
+
+    frame_nr++;
+    memset (current_frame (), 0, sizeof(frame_record_t));
+}
+
+void telemetry_rst (const int rst, const uint64_t cycles)
+{
+    frame_record_t* f = current_frame ();
+
+    if (rst == 1) {
+        f->rst1 = rdtsc ();
+    } else {
+        f->rst2 = rdtsc ();
+        const uint32_t start = __atomic_exchange_n (&render_start, 0, __ATOMIC_RELAXED);
+        f->render_ticks = __atomic_exchange_n (&render_ticks, 0, __ATOMIC_RELAXED);
+        f->render_start = start ? (f->rst2 - (uint32_t)((uint32_t)f->rst2 - start)) : 0;
+        f->cycles = (uint32_t)(cycles - last_cycles);
+        last_cycles = cycles;
+        telemetry_end_frame (f);
+        pmu_frame ();
+    }
+}
+
+void telemetry_render (const uint64_t start, const uint64_t end)
+{
+    uint32_t none = 0;
+
+    __atomic_compare_exchange_n (&render_start, &none, (uint32_t)start | 1, false,
+                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&render_ticks, (uint32_t)(end - start), __ATOMIC_RELAXED);
+}
+
+static void print_signed (const char* fmt, const int64_t val)
+{
+    printf (fmt, (val < 0) ? "-" : "", (unsigned)((val < 0) ? -val : val));
+}
+
+void telemetry_report (void)
+{
+    const frame_record_t* last = &frames[(frame_nr - 1) & frame_mask];
+
+    printf ("telemetry: %u frames, %u late (> %uus), last frame %u 8080 cycles\n",
+            frame_nr, late_frames, LATE_FRAME_US, last->cycles);
+
+    print_signed ("  jitter min %s%uus", jitter_min_us);
+    print_signed (" max %s%uus\n", jitter_max_us);
+    for (int i = 0; i < JITTER_BUCKETS; ++i) {
+        const int64_t lo = (int64_t)(i - JITTER_BUCKETS/2) * JITTER_STEP_US;
+        print_signed ("  jitter %s%4uus", lo);
+        printf (" %8u\n", jitter_hist[i]);
+    }
+    for (int i = 0; i < RENDER_BUCKETS; ++i) {
+        printf ("  render < %6uus %8u\n", 1u << i, render_hist[i]);
+    }
+    pmu_report ();
+}
+
+void telemetry_poll (void)
+{
+    const uint64_t now = now_ns ();
+
+    if (now >= next_report_ns) {
+        next_report_ns = now + REPORT_INTERVAL_NS;
+        telemetry_report ();
+    }
+}
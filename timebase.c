@@ -0,0 +1,134 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "x86.h"
+#include "stdio.h"
+
+#include "timebase.h"
+
+/* PIT channel 2 gate and output are in the keyboard controller port B */
+#define PORT_B          0x61
+#define PORT_B_GATE2    0x01
+#define PORT_B_SPEAKER  0x02
+#define PORT_B_OUT2     0x20
+
+#define CALIBRATE_MS    10
+#define CALIBRATE_COUNT ((PIT_HZ * CALIBRATE_MS) / 1000)
+
+static uint64_t tsc_hz;
+static uint64_t tsc_boot;
+
+/* nanoseconds per tick and ticks per nanosecond, both 32.32 fixed point */
+static uint64_t ns_per_tick;
+static uint64_t ticks_per_ns;
+
+/* (a * b) >> 32 without overflowing the 64-bit intermediate products */
+static inline uint64_t mul_shr32 (const uint64_t a, const uint64_t b)
+{
+    const uint64_t ah = a >> 32, al = a & 0xffffffff;
+    const uint64_t bh = b >> 32, bl = b & 0xffffffff;
+    return ((ah * bh) << 32) + (ah * bl) + (al * bh) + ((al * bl) >> 32);
+}
+
+/* Count TSC ticks while PIT channel 2 counts down CALIBRATE_COUNT in mode 0,
+   the shortest of a few runs is used to discount SMIs and virtualisation
+   exits.
+*/
+static uint64_t timebase_calibrate (void)
+{
+    uint64_t best = ~0ull;
+
+    for (int run = 0; run < 3; ++run) {
+        uint8_t b = inport8 (PORT_B);
+        /* gate low, speaker off */
+        outport8 (PORT_B, b & ~(PORT_B_GATE2 | PORT_B_SPEAKER));
+
+        /* channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+        outport8 (0x43, 0xb0);
+        outport8 (0x42, CALIBRATE_COUNT & 0xff);
+        outport8 (0x42, (CALIBRATE_COUNT >> 8) & 0xff);
+
+        /* gate high starts the count */
+        b = inport8 (PORT_B);
+        outport8 (PORT_B, (b & ~PORT_B_SPEAKER) | PORT_B_GATE2);
+
+        uint64_t start = rdtsc ();
+        while ((inport8 (PORT_B) & PORT_B_OUT2) == 0);
+        uint64_t ticks = rdtsc () - start;
+
+        if (ticks < best) {
+            best = ticks;
+        }
+    }
+
+    outport8 (PORT_B, inport8 (PORT_B) & ~(PORT_B_GATE2 | PORT_B_SPEAKER));
+
+    return (best * 1000) / CALIBRATE_MS;
+}
+
+void timebase_init (void)
+{
+    tsc_hz = timebase_calibrate ();
+    ns_per_tick = (1000000000ull << 32) / tsc_hz;
+    ticks_per_ns = ((tsc_hz / 1000) << 32) / 1000000ull;
+    tsc_boot = rdtsc ();
+
+    /* without an invariant TSC the rate may change with power states */
+    bool invariant = false;
+    if (cpuid (0x80000000).eax >= 0x80000007) {
+        invariant = (cpuid (0x80000007).edx & (1 << 8)) != 0;
+    }
+
+    printf ("TSC: %u kHz%s\n", (unsigned)(tsc_hz / 1000), invariant ? " (invariant)" : "");
+}
+
+uint64_t timebase_tsc_hz (void)
+{
+    return tsc_hz;
+}
+
+uint64_t timebase_ticks_to_ns (const uint64_t ticks)
+{
+    return mul_shr32 (ticks, ns_per_tick);
+}
+
+uint64_t timebase_ns_to_ticks (const uint64_t ns)
+{
+    return mul_shr32 (ns, ticks_per_ns);
+}
+
+uint64_t now_ns (void)
+{
+    return timebase_ticks_to_ns (rdtsc () - tsc_boot);
+}
+
+void timebase_delay_us (const unsigned us)
+{
+    const uint64_t start = rdtsc ();
+    const uint64_t ticks = timebase_ns_to_ticks ((uint64_t)us * 1000);
+    while ((rdtsc () - start) < ticks) {
+        asm volatile ("pause");
+    }
+}
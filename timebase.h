@@ -0,0 +1,56 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef __TIMEBASE_H__
+#define __TIMEBASE_H__
+
+#include <stdint.h>
+
+#include "x86.h"
+
+/* TSC based time, calibrated against the PIT at boot */
+
+#define PIT_HZ 1193182
+
+void timebase_init (void);
+
+/* TSC frequency in Hz */
+uint64_t timebase_tsc_hz (void);
+
+/* convert a number of TSC ticks to nanoseconds */
+uint64_t timebase_ticks_to_ns (const uint64_t ticks);
+
+/* convert nanoseconds to a number of TSC ticks */
+uint64_t timebase_ns_to_ticks (const uint64_t ns);
+
+/* time since timebase_init */
+uint64_t now_ns (void);
+
+static inline uint64_t now_us (void)
+{
+    return now_ns () / 1000;
+}
+
+/* busy wait */
+void timebase_delay_us (const unsigned us);
+
+#endif /* __TIMEBASE_H__ */
@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <stdint.h>
+
+#include "x86.h"
+#include "timebase.h"
+#include "apic.h"
+
+#include "timer.h"
+
+static timer_event_handler_t timer_event_handler;
+
+/* TSC ticks between screen events and the TSC value of the next event */
+static uint64_t event_ticks;
+static uint64_t next_event;
+
+/* PIT counts per TSC tick, 32.32 fixed point */
+static uint64_t pit_per_tick;
+
+/* raise the next timer interrupt when the TSC reaches 'deadline' */
+typedef void (*timer_arm_fn_t) (const uint64_t deadline);
+static timer_arm_fn_t timer_arm;
+
+/* Start PIT channel 0 counting down to 'deadline' in mode 0, IRQ 0 is raised
+   once when it reaches zero.
+*/
+static void pit_arm (const uint64_t deadline)
+{
+    const uint64_t now = rdtsc ();
+    uint64_t count = 1;
+
+    if ((int64_t)(deadline - now) > 0) {
+        count = ((deadline - now) * pit_per_tick) >> 32;
+    }
+
+    if (count < 1) {
+        count = 1;
+    } else if (count > 0xffff) {
+        count = 0xffff;
+    }
+
+    outport8 (0x43, 0x30); /* channel 0, lobyte/hibyte, mode 0 */
+    outport8 (0x40, (uint8_t)(count & 0xff));
+    outport8 (0x40, (uint8_t)((count >> 8) & 0xff));
+}
+
+/* The next event is programmed before the handler runs so the time taken by
+   the handler does not delay it. If an event is missed the schedule restarts
+   from now rather than trying to catch up.
+*/
+static void timer_event (void)
+{
+    const uint64_t now = rdtsc ();
+
+    next_event += event_ticks;
+    if ((int64_t)(next_event - now) <= 0) {
+        next_event = now + event_ticks;
+    }
+    timer_arm (next_event);
+
+    timer_event_handler ();
+}
+
+/* IRQ 0, PIT channel 0 */
+void timer_irq_handler (void)
+{
+    timer_event ();
+}
+
+/* local APIC timer */
+void apic_timer_irq_handler (void)
+{
+    timer_event ();
+}
+
+/* Prefer the local APIC timer, it can be programmed for an exact TSC value
+   and has no 16-bit count limit. The PIT is the fallback.
+*/
+void timer_init (timer_event_handler_t handler)
+{
+    timer_event_handler = handler;
+
+    event_ticks = timebase_ns_to_ticks (VIDEO_FRAME_NS / 2);
+    pit_per_tick = ((uint64_t)PIT_HZ << 32) / timebase_tsc_hz ();
+
+    if (apic_init () && apic_timer_init ()) {
+        /* mask IRQ 0 at the master PIC */
+        outport8 (0x21, inport8 (0x21) | 0x01);
+        timer_arm = apic_timer_arm;
+    } else {
+        timer_arm = pit_arm;
+    }
+
+    next_event = rdtsc () + event_ticks;
+    timer_arm (next_event);
+}
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+#-------------------------------------------------------------------------------
+#  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to deal
+#  in the Software without restriction, including without limitation the rights
+#  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#  copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+#
+#-------------------------------------------------------------------------------
+#
+# Turn the recording printed by movie_report (movie.c) back into a movie file.
+#
+#   tools/movie.py serial.log invaders.mov
+#
+# The log is the COM1 output of a run booted with the "record" option. The
+# file is replayed by loading it as the second multiboot module, see the
+# "pc-invaders (replay)" GRUB entry.
+
+import sys
+
+
+def read_movie(log):
+    data = bytearray()
+    for line in log:
+        if not line.startswith("movie:"):
+            continue
+        fields = line.split()
+        if fields[1] == "end":
+            return bytes(data)
+        if fields[1] == "recorded":
+            continue
+        data.extend(int(f, 16) for f in fields[1:])
+    return None
+
+
+def main():
+    if len(sys.argv) < 3:
+        print("usage: %s <serial log> <movie file>" % sys.argv[0])
+        return 1
+
+    with open(sys.argv[1], errors="replace") as log:
+        data = read_movie(log)
+
+    if not data:
+        print("no movie in %s" % sys.argv[1])
+        return 1
+
+    with open(sys.argv[2], "wb") as f:
+        f.write(data)
+    print("%s: %u bytes" % (sys.argv[2], len(data)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
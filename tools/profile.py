@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#-------------------------------------------------------------------------------
+#  Copyright (c) 2018 Brendan Fennell <bfennell@skynet.ie>
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to deal
+#  in the Software without restriction, including without limitation the rights
+#  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#  copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+#
+#-------------------------------------------------------------------------------
+#
+# Symbolise the sample histogram printed by profile_report (profile.c).
+#
+#   tools/profile.py pc-invaders-x86_64 serial.log
+#
+# The log is the COM1 output of a run booted with the "profile" option, the
+# symbols are read from the kernel ELF with nm.
+
+import bisect
+import subprocess
+import sys
+
+
+def read_symbols(elf, nm):
+    out = subprocess.run([nm, "-n", "--defined-only", elf],
+                         check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[1] in "tTwW":
+            addrs.append(int(fields[0], 16))
+            names.append(fields[2])
+    return addrs, names
+
+
+def read_samples(log):
+    samples = {}
+    header = None
+    for line in log:
+        if not line.startswith("profile: "):
+            continue
+        fields = line.split()
+        if fields[1] == "end":
+            break
+        if len(fields) == 3:
+            samples[int(fields[1], 16)] = int(fields[2])
+        else:
+            header = line.strip()
+    return header, samples
+
+
+def main():
+    if len(sys.argv) < 3:
+        print("usage: %s <kernel elf> <serial log> [nm]" % sys.argv[0])
+        return 1
+
+    nm = sys.argv[3] if len(sys.argv) > 3 else "nm"
+    addrs, names = read_symbols(sys.argv[1], nm)
+    with open(sys.argv[2], errors="replace") as log:
+        header, samples = read_samples(log)
+
+    if header is None:
+        print("no profile in %s" % sys.argv[2])
+        return 1
+
+    funcs = {}
+    for addr, count in samples.items():
+        i = bisect.bisect_right(addrs, addr) - 1
+        name = names[i] if i >= 0 else "0x%08x" % addr
+        funcs[name] = funcs.get(name, 0) + count
+
+    total = sum(funcs.values())
+    print(header)
+    print("%8s %6s  %s" % ("samples", "%", "function"))
+    for name, count in sorted(funcs.items(), key=lambda f: -f[1]):
+        print("%8u %6.2f  %s" % (count, 100.0 * count / total, name))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
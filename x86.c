@@ -26,24 +26,6 @@
 #include "stdio.h"
 #include "x86.h"
 
-typedef struct {
-    unsigned eax;
-    unsigned ebx;
-    unsigned edx;
-    unsigned ecx;
-} cpuid_t;
-
-static inline cpuid_t cpuid (uint32_t eax)
-{
-    cpuid_t regs;
-    asm volatile ("cpuid\n\t"
-                  : "=a" (regs.eax), "=b" (regs.ebx), "=c" (regs.ecx), "=d" (regs.edx)
-                  : "a" (eax), "c" (0)
-                  );
-
-    return regs;
-}
-
 void show_cpu_info (void)
 {
     union {
@@ -88,6 +88,13 @@
 
 #define INTERRUPT_GATE 0x8e
 
+/* extended processor state */
+#define CPUID1_ECX_XSAVE (1 << 26)
+#define CPUID1_ECX_AVX   (1 << 28)
+#define XCR0_X87 (1 << 0)
+#define XCR0_SSE (1 << 1)
+#define XCR0_AVX (1 << 2)
+
 #ifndef __ASSEMBLER__
 #include <stdint.h>
 
@@ -105,6 +112,66 @@ static inline void outport8 (const uint16_t port, uint8_t val)
     asm volatile ("out %%al, %%dx" : /* no inputs */ : "a" (val), "d" (port));
 }
 
+static inline uint16_t inport16 (const uint16_t port)
+{
+    uint16_t val;
+    asm volatile ("in %%dx, %%ax" : "=a" (val) : "d" (port));
+    return val;
+}
+
+static inline void outport16 (const uint16_t port, uint16_t val)
+{
+    asm volatile ("out %%ax, %%dx" : /* no inputs */ : "a" (val), "d" (port));
+}
+
+static inline uint32_t inport32 (const uint16_t port)
+{
+    uint32_t val;
+    asm volatile ("in %%dx, %%eax" : "=a" (val) : "d" (port));
+    return val;
+}
+
+static inline void outport32 (const uint16_t port, uint32_t val)
+{
+    asm volatile ("out %%eax, %%dx" : /* no inputs */ : "a" (val), "d" (port));
+}
+
+typedef struct {
+    unsigned eax;
+    unsigned ebx;
+    unsigned edx;
+    unsigned ecx;
+} cpuid_t;
+
+static inline cpuid_t cpuid (uint32_t eax)
+{
+    cpuid_t regs;
+    asm volatile ("cpuid\n\t"
+                  : "=a" (regs.eax), "=b" (regs.ebx), "=c" (regs.ecx), "=d" (regs.edx)
+                  : "a" (eax), "c" (0)
+                  );
+
+    return regs;
+}
+
+/* read performance monitoring counter 'counter', bit 30 selects the fixed
+   function counters
+*/
+static inline uint64_t rdpmc (uint32_t counter)
+{
+    uint32_t low, high;
+    asm volatile ("rdpmc" : "=a" (low), "=d" (high) : "c" (counter));
+    return ((uint64_t)high << 32) | low;
+}
+
+/* read the time stamp counter */
+static inline uint64_t rdtsc (void)
+{
+    uint32_t low, high;
+    asm volatile ("rdtsc" : "=a" (low), "=d" (high));
+    return ((uint64_t)high << 32) | low;
+}
+
 static inline void irq_enable (void)
 {
     asm volatile ("sti");
@@ -115,12 +182,25 @@ static inline void irq_disable (void)
     asm volatile ("cli");
 }
 
+/* disable interrupts, returns the previous flags for irq_restore */
+static inline unsigned long irq_save (void)
+{
+    unsigned long flags;
+    asm volatile ("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore (const unsigned long flags)
+{
+    asm volatile ("push %0; popf" : : "r" (flags) : "memory", "cc");
+}
+
 static inline void set_msr(uint32_t msr_id, uint64_t msr_value)
 {
     asm volatile ( "wrmsr" : : "c" (msr_id), "A" (msr_value) );
 }
 
-static inline void wrmsr(uint64_t msr, uint64_t value)
+static inline void wrmsr(uint32_t msr, uint64_t value)
 {
     uint32_t low = value & 0xFFFFFFFF;
     uint32_t high = value >> 32;
@@ -138,7 +218,7 @@ static inline uint64_t get_msr (uint32_t msr)
     return val;
 }
 
-static inline uint64_t rdmsr(uint64_t msr)
+static inline uint64_t rdmsr(uint32_t msr)
 {
     uint32_t low, high;
     asm volatile (